@@ -0,0 +1,303 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#ifndef BPTREE_HPP__
+#define BPTREE_HPP__
+
+#include <climits>
+#include <vector>
+#include <api/api.hpp> // need this for malloc and free
+
+// Set of integers represented as a B+tree.  Every node holds at most
+// fanout-1 keys (and internal nodes at most fanout children), and the leaves
+// are linked in key order for range scans.
+//
+// Inserts split full nodes on the way down, so an insert never has to walk
+// back up the tree.  Removes only take the key out of its leaf: nodes are
+// never merged, so leaves may become empty, but they stay linked and the
+// separators above them stay valid bounds.
+class BPTree
+{
+  public:
+    static const uint32_t MAX_FANOUT = 64;
+
+  private:
+    // Node in a BPTree.  Only the first m_fanout entries of each array are
+    // ever used.
+    struct Node
+    {
+        int   m_leaf;                   // immutable
+        int   m_count;                  // keys in use
+        Node* m_next;                   // next leaf (leaves only)
+        int   m_keys[MAX_FANOUT];
+        Node* m_child[MAX_FANOUT];      // internal nodes only
+    };
+
+    uint32_t m_fanout;
+    Node*    m_root;
+
+    // index of the child of n whose subtree holds val
+    TM_CALLABLE
+    static uint32_t childIndex(const Node* n, int val TM_ARG);
+
+    // split the full node child, which is parent's i'th child, in two
+    TM_CALLABLE
+    void splitChild(Node* parent, uint32_t i, Node* child TM_ARG);
+
+    // the leaf whose range holds val
+    TM_CALLABLE
+    const Node* findLeaf(int val TM_ARG) const;
+
+    // check the subtree at n, whose keys must be in [lo, hi], appending its
+    // leaves to 'leaves'
+    bool checkNode(const Node* n, long lo, long hi, int depth, int& leafdepth,
+                   std::vector<const Node*>& leaves) const;
+
+  public:
+
+    BPTree(uint32_t fanout);
+
+    // true iff val is in the data structure
+    TM_CALLABLE
+    bool lookup(int val TM_ARG) const;
+
+    // standard IntSet methods
+    TM_CALLABLE
+    void insert(int val TM_ARG);
+
+    TM_CALLABLE
+    void remove(int val TM_ARG);
+
+    // count the elements in [lo, hi]
+    TM_CALLABLE
+    uint32_t scan(int lo, int hi TM_ARG) const;
+
+    // make sure keys are sorted and within their separators, every leaf is
+    // at the same depth, and the leaf chain visits the leaves in order
+    bool isSane() const;
+};
+
+// constructor: the tree starts as one empty leaf
+BPTree::BPTree(uint32_t fanout)
+    : m_fanout(fanout < 4 ? 4 : (fanout > MAX_FANOUT ? MAX_FANOUT : fanout)),
+      m_root((Node*)malloc(sizeof(Node)))
+{
+    m_root->m_leaf = 1;
+    m_root->m_count = 0;
+    m_root->m_next = NULL;
+}
+
+// linear search: wide nodes are scanned the way a cache-conscious tree would
+TM_CALLABLE
+uint32_t BPTree::childIndex(const Node* n, int val TM_ARG)
+{
+    uint32_t count = TM_READ(n->m_count);
+    uint32_t i = 0;
+    while ((i < count) && (TM_READ(n->m_keys[i]) <= val))
+        ++i;
+    return i;
+}
+
+// move the upper half of child into a new sibling, and put the separator
+// into parent
+TM_CALLABLE
+void BPTree::splitChild(Node* parent, uint32_t i, Node* child TM_ARG)
+{
+    // the sibling is private until we link it into parent
+    Node* sib = (Node*)TM_ALLOC(sizeof(Node));
+    int leaf = TM_READ(child->m_leaf);
+    uint32_t n = TM_READ(child->m_count);
+    uint32_t mid = n / 2;
+    int sep;
+    sib->m_leaf = leaf;
+    if (leaf) {
+        // leaves keep every key; the separator is a copy of sib's first key
+        sib->m_count = n - mid;
+        for (uint32_t j = mid; j < n; ++j)
+            sib->m_keys[j - mid] = TM_READ(child->m_keys[j]);
+        sib->m_next = TM_READ(child->m_next);
+        TM_WRITE(child->m_next, sib);
+        sep = sib->m_keys[0];
+    }
+    else {
+        // internal nodes move the middle key up to parent
+        sep = TM_READ(child->m_keys[mid]);
+        sib->m_count = n - mid - 1;
+        for (uint32_t j = mid + 1; j < n; ++j)
+            sib->m_keys[j - mid - 1] = TM_READ(child->m_keys[j]);
+        for (uint32_t j = mid + 1; j <= n; ++j)
+            sib->m_child[j - mid - 1] = TM_READ(child->m_child[j]);
+        sib->m_next = NULL;
+    }
+    TM_WRITE(child->m_count, (int)mid);
+
+    // make room for the separator and sib in parent
+    uint32_t pc = TM_READ(parent->m_count);
+    for (uint32_t j = pc; j > i; --j) {
+        TM_WRITE(parent->m_keys[j], TM_READ(parent->m_keys[j - 1]));
+        TM_WRITE(parent->m_child[j + 1], TM_READ(parent->m_child[j]));
+    }
+    TM_WRITE(parent->m_keys[i], sep);
+    TM_WRITE(parent->m_child[i + 1], sib);
+    TM_WRITE(parent->m_count, (int)(pc + 1));
+}
+
+// descend from the root to a leaf
+TM_CALLABLE
+const BPTree::Node* BPTree::findLeaf(int val TM_ARG) const
+{
+    const Node* x = TM_READ(m_root);
+    while (!TM_READ(x->m_leaf))
+        x = TM_READ(x->m_child[childIndex(x, val TM_PARAM)]);
+    return x;
+}
+
+// search function
+TM_CALLABLE
+bool BPTree::lookup(int val TM_ARG) const
+{
+    const Node* leaf = findLeaf(val TM_PARAM);
+    uint32_t count = TM_READ(leaf->m_count);
+    for (uint32_t i = 0; i < count; ++i) {
+        int k = TM_READ(leaf->m_keys[i]);
+        if (k >= val)
+            return k == val;
+    }
+    return false;
+}
+
+// insert method; if val is already in the tree, exit without inserting
+TM_CALLABLE
+void BPTree::insert(int val TM_ARG)
+{
+    // a full root is split under a new root, which is how the tree grows
+    Node* x = TM_READ(m_root);
+    if ((uint32_t)TM_READ(x->m_count) == m_fanout - 1) {
+        Node* r = (Node*)TM_ALLOC(sizeof(Node));
+        r->m_leaf = 0;
+        r->m_count = 0;
+        r->m_next = NULL;
+        r->m_child[0] = x;
+        splitChild(r, 0, x TM_PARAM);
+        TM_WRITE(m_root, r);
+        x = r;
+    }
+
+    // descend, splitting any full node before we enter it
+    while (!TM_READ(x->m_leaf)) {
+        uint32_t i = childIndex(x, val TM_PARAM);
+        Node* c = TM_READ(x->m_child[i]);
+        if ((uint32_t)TM_READ(c->m_count) == m_fanout - 1) {
+            splitChild(x, i, c TM_PARAM);
+            if (val >= TM_READ(x->m_keys[i]))
+                c = TM_READ(x->m_child[i + 1]);
+        }
+        x = c;
+    }
+
+    // find the position in the leaf, and shift the larger keys over
+    uint32_t count = TM_READ(x->m_count);
+    uint32_t pos = 0;
+    for (; pos < count; ++pos) {
+        int k = TM_READ(x->m_keys[pos]);
+        if (k == val)
+            return;
+        if (k > val)
+            break;
+    }
+    for (uint32_t j = count; j > pos; --j)
+        TM_WRITE(x->m_keys[j], TM_READ(x->m_keys[j - 1]));
+    TM_WRITE(x->m_keys[pos], val);
+    TM_WRITE(x->m_count, (int)(count + 1));
+}
+
+// remove a key if it is in the tree
+TM_CALLABLE
+void BPTree::remove(int val TM_ARG)
+{
+    Node* leaf = const_cast<Node*>(findLeaf(val TM_PARAM));
+    uint32_t count = TM_READ(leaf->m_count);
+    for (uint32_t pos = 0; pos < count; ++pos) {
+        int k = TM_READ(leaf->m_keys[pos]);
+        if (k > val)
+            return;
+        if (k == val) {
+            for (uint32_t j = pos + 1; j < count; ++j)
+                TM_WRITE(leaf->m_keys[j - 1], TM_READ(leaf->m_keys[j]));
+            TM_WRITE(leaf->m_count, (int)(count - 1));
+            return;
+        }
+    }
+}
+
+// range scan: find lo's leaf, then follow the leaf chain
+TM_CALLABLE
+uint32_t BPTree::scan(int lo, int hi TM_ARG) const
+{
+    uint32_t found = 0;
+    const Node* leaf = findLeaf(lo TM_PARAM);
+    while (leaf != NULL) {
+        uint32_t count = TM_READ(leaf->m_count);
+        for (uint32_t i = 0; i < count; ++i) {
+            int k = TM_READ(leaf->m_keys[i]);
+            if (k > hi)
+                return found;
+            if (k >= lo)
+                ++found;
+        }
+        leaf = TM_READ(leaf->m_next);
+    }
+    return found;
+}
+
+// recursive part of the sanity check
+bool BPTree::checkNode(const Node* n, long lo, long hi, int depth,
+                       int& leafdepth, std::vector<const Node*>& leaves) const
+{
+    if ((n->m_count < 0) || ((uint32_t)n->m_count >= m_fanout))
+        return false;
+    for (int i = 0; i < n->m_count; ++i) {
+        if ((n->m_keys[i] < lo) || (n->m_keys[i] > hi))
+            return false;
+        if ((i > 0) && (n->m_keys[i - 1] >= n->m_keys[i]))
+            return false;
+    }
+    if (n->m_leaf) {
+        if (leafdepth == -1)
+            leafdepth = depth;
+        leaves.push_back(n);
+        return leafdepth == depth;
+    }
+    // child i holds keys in [keys[i-1], keys[i])
+    for (int i = 0; i <= n->m_count; ++i) {
+        long clo = (i == 0) ? lo : n->m_keys[i - 1];
+        long chi = (i == n->m_count) ? hi : (long)n->m_keys[i] - 1;
+        if (!checkNode(n->m_child[i], clo, chi, depth + 1, leafdepth, leaves))
+            return false;
+    }
+    return true;
+}
+
+// sanity check: the tree is ordered and balanced, and the leaf chain agrees
+// with it
+bool BPTree::isSane() const
+{
+    int leafdepth = -1;
+    std::vector<const Node*> leaves;
+    if (!checkNode(m_root, INT_MIN, INT_MAX, 0, leafdepth, leaves))
+        return false;
+    const Node* chain = leaves[0];
+    for (size_t i = 0; i < leaves.size(); ++i, chain = chain->m_next)
+        if (chain != leaves[i])
+            return false;
+    return chain == NULL;
+}
+
+#endif // BPTREE_HPP__
@@ -0,0 +1,148 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <iostream>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *    A bank is an array of CFG.elements account balances.  Transfers move
+ *    money between two accounts (CFG.ops transfers per transaction), balance
+ *    queries read one account, and audits read every account and check that
+ *    no money has been created or destroyed.  Audits are long read-only
+ *    transactions that conflict with every short writer.
+ */
+
+const intptr_t INITIAL_BALANCE = 1000;
+
+/*** most transfers in one transaction */
+const uint32_t MAX_TRANSFERS = 64;
+
+intptr_t* accounts;
+
+/*** audits that saw the wrong total; any is a failure */
+volatile uint32_t audit_failures = 0;
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Open all the accounts */
+void bench_init()
+{
+    accounts = (intptr_t*)malloc(CFG.elements * sizeof(intptr_t));
+    for (uint32_t i = 0; i < CFG.elements; ++i)
+        accounts[i] = INITIAL_BALANCE;
+}
+
+/*** Run an audit, a balance query, or some transfers */
+void bench_test(uintptr_t id, uint32_t* seed)
+{
+    uint32_t act = rand_r(seed) % 100;
+    if (act < CFG.scanpct) {
+        // NB: volatile needed because using a non-volatile local in
+        //     conjunction with a setjmp-longjmp control transfer is undefined
+        volatile intptr_t sum = 0;
+        TM_BEGIN(readonly) {
+            sum = 0;
+            for (uint32_t i = 0; i < CFG.elements; ++i)
+                sum += TM_READ(accounts[i]);
+        } TM_END;
+        if (sum != INITIAL_BALANCE * (intptr_t)CFG.elements)
+            fai32(&audit_failures);
+    }
+    else if (act < CFG.lookpct) {
+        uint32_t acct = KEYS.next(id, seed);
+        volatile intptr_t balance = 0;
+        TM_BEGIN(readonly) {
+            balance = TM_READ(accounts[acct]);
+        } TM_END;
+        (void)balance;
+    }
+    else {
+        // draw the transfers up front, so that a retry does not advance the
+        // key generator and skew the key distribution
+        uint32_t src[MAX_TRANSFERS], dst[MAX_TRANSFERS];
+        intptr_t amount[MAX_TRANSFERS];
+        for (uint32_t i = 0; i < CFG.ops; ++i) {
+            src[i] = KEYS.next(id, seed);
+            dst[i] = (src[i] + 1 + rand_r(seed) % (CFG.elements - 1))
+                   % CFG.elements;
+            amount[i] = 1 + rand_r(seed) % 100;
+        }
+        TM_BEGIN(atomic) {
+            for (uint32_t i = 0; i < CFG.ops; ++i) {
+                intptr_t from = TM_READ(accounts[src[i]]);
+                if (from >= amount[i]) {
+                    TM_WRITE(accounts[src[i]], from - amount[i]);
+                    TM_WRITE(accounts[dst[i]],
+                             TM_READ(accounts[dst[i]]) + amount[i]);
+                }
+            }
+        } TM_END;
+    }
+}
+
+/*** Every audit balanced, and so do the books at the end */
+bool bench_verify()
+{
+    intptr_t sum = 0;
+    for (uint32_t i = 0; i < CFG.elements; ++i) {
+        if (accounts[i] < 0)
+            return false;
+        sum += accounts[i];
+    }
+    if (audit_failures)
+        std::cout << "(" << audit_failures << " failed audits) ";
+    return (audit_failures == 0) &&
+           (sum == INITIAL_BALANCE * (intptr_t)CFG.elements);
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "Bank";
+    // a transfer needs two distinct accounts
+    if (CFG.elements < 2) CFG.elements = 2;
+    if (CFG.ops > MAX_TRANSFERS) CFG.ops = MAX_TRANSFERS;
+}
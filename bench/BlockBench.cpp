@@ -0,0 +1,144 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <iostream>
+#include <cstring>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *    This benchmark stresses the block operations (TM_MEMCPY, TM_MEMSET and
+ *    TM_MEMCMP).  There are -m records of -G bytes each, and every byte of a
+ *    record always holds the same value.  Transactions copy one record over
+ *    another, fill a record with a new value, or check that a record is
+ *    uniform by comparing it with itself shifted by one byte.
+ *
+ *    The records are packed, starting one byte into a word, so that every
+ *    operation has an unaligned head and tail around its aligned middle,
+ *    and neighbouring records share words.  The aligned middle goes through
+ *    the block barriers.  Only the OrecEager, OrecLazy and NOrec families
+ *    batch them: the orec families check one orec per run of words that
+ *    share it, which only saves work when libstm_orec_granularity is
+ *    coarser than 'word', and NOrec checks the sequence lock once per
+ *    block.  Every other algorithm calls its word barriers once per word,
+ *    so for them this measures the word barriers.
+ *
+ *    -R sets the percentage of checks, and the remaining transactions are
+ *    split evenly between copies and fills.
+ */
+
+uint8_t* buffer;
+uint8_t* records;
+
+/*** checks that found a record that was not uniform; any is a failure */
+volatile uint32_t check_failures = 0;
+
+/*** the address of a record */
+inline uint8_t* record(uint32_t i)
+{
+    return records + i * CFG.scanlen;
+}
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Fill every record with its own byte */
+void bench_init()
+{
+    buffer = new uint8_t[CFG.elements * CFG.scanlen + sizeof(void*)];
+    records = buffer + 1;
+    for (uint32_t i = 0; i < CFG.elements; ++i)
+        memset(record(i), (int)(i & 0xFF), CFG.scanlen);
+}
+
+/*** Run a check, a copy, or a fill */
+void bench_test(uintptr_t id, uint32_t* seed)
+{
+    uint32_t act = rand_r(seed) % 100;
+    uint32_t dst = KEYS.next(id, seed);
+
+    if (act < CFG.lookpct) {
+        // NB: volatile needed because using a non-volatile local in
+        //     conjunction with a setjmp-longjmp control transfer is undefined
+        volatile int r = 0;
+        TM_BEGIN(readonly) {
+            r = TM_MEMCMP(record(dst), record(dst) + 1, CFG.scanlen - 1);
+        } TM_END;
+        if (r != 0)
+            fai32(&check_failures);
+    }
+    else if (act < CFG.inspct) {
+        uint32_t src = (dst + 1 + rand_r(seed) % (CFG.elements - 1))
+                     % CFG.elements;
+        TM_BEGIN(atomic) {
+            TM_MEMCPY(record(dst), record(src), CFG.scanlen);
+        } TM_END;
+    }
+    else {
+        int c = rand_r(seed) & 0xFF;
+        TM_BEGIN(atomic) {
+            TM_MEMSET(record(dst), c, CFG.scanlen);
+        } TM_END;
+    }
+}
+
+/*** Every check passed, and every record is still uniform */
+bool bench_verify()
+{
+    for (uint32_t i = 0; i < CFG.elements; ++i)
+        if (memcmp(record(i), record(i) + 1, CFG.scanlen - 1))
+            return false;
+    if (check_failures)
+        std::cout << "(" << check_failures << " failed checks) ";
+    return check_failures == 0;
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "Block";
+    // a copy needs two distinct records, and a check needs two bytes
+    if (CFG.elements < 2) CFG.elements = 2;
+    if (CFG.scanlen < 2)  CFG.scanlen = 2;
+}
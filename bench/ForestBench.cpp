@@ -101,6 +101,9 @@ struct CustomForest
 /*** the tree we will manipulate in the experiment */
 CustomForest* SET;
 
+/*** most tree ops in one transaction */
+const uint32_t MAX_OPS = 256;
+
 /*** Initialize the counter */
 void bench_init()
 {
@@ -108,33 +111,32 @@ void bench_init()
 }
 
 /*** Run a bunch of random transactions */
-void bench_test(uintptr_t, uint32_t* seed)
+void bench_test(uintptr_t id, uint32_t* seed)
 {
-    // cache the seed locally so we can restore it on abort
-    //
-    // NB: volatile needed because using a non-volatile local in conjunction
-    //     with a setjmp-longjmp control transfer is undefined, and gcc won't
-    //     allow it with -Wall -Werror.
-    volatile uint32_t local_seed = *seed;
+    // draw the ops up front, so that a retry does not advance the key
+    // generator and skew the key distribution
+    uint32_t tree_idx[MAX_OPS], act[MAX_OPS];
+    int val[MAX_OPS];
+    for (uint32_t i = 0; i < SET->trees_per_tx; ++i) {
+        // pick a tree, a value, and a read-only ratio
+        tree_idx[i] = rand_r(seed) % SET->total_trees;
+        val[i] = KEYS.next(id, seed);
+        act[i] = rand_r(seed) % 100;
+    }
     TM_BEGIN(atomic) {
         if (CFG.running) {
-            local_seed = *seed;
             for (uint32_t i = 0; i < SET->trees_per_tx; ++i) {
-                // pick a tree, a value, and a read-only ratio
-                int tree_idx = rand_r((uint32_t*)&local_seed) % SET->total_trees;
-                int val = rand_r((uint32_t*)&local_seed) % SET->keydepths;
-                uint32_t act = rand_r((uint32_t*)&local_seed) % 100;
+                RBTree* tree = SET->trees[tree_idx[i]];
                 // do a lookup?
-                if (act < SET->roratio)
-                    SET->trees[tree_idx]->lookup(val TM_PARAM);
-                else if (act < SET->insratio)
-                    SET->trees[tree_idx]->insert(val TM_PARAM);
+                if (act[i] < SET->roratio)
+                    tree->lookup(val[i] TM_PARAM);
+                else if (act[i] < SET->insratio)
+                    tree->insert(val[i] TM_PARAM);
                 else
-                    SET->trees[tree_idx]->remove(val TM_PARAM);
+                    tree->remove(val[i] TM_PARAM);
             }
         }
     } TM_END;
-    *seed = local_seed;
 }
 
 /*** Ensure the final state of the benchmark satisfies all invariants */
@@ -157,4 +159,5 @@ bool bench_verify()
 void bench_reparse()
 {
     if (CFG.bmname == "") CFG.bmname   = "Forest";
+    if (CFG.ops > MAX_OPS) CFG.ops = MAX_OPS;
 }
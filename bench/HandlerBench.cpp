@@ -0,0 +1,142 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <iostream>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *    This benchmark checks the deferred work of stm::on_commit and
+ *    stm::on_abort.  Every attempt of every transaction registers a handler
+ *    of each kind, which counts its runs in a per-thread counter, and then
+ *    increments a shared counter.  Some transactions restart themselves a
+ *    few times, and others abort on conflicts over the counter.
+ *
+ *    After each transaction, the thread checks that the commit handlers
+ *    have run exactly once per commit, and the abort handlers exactly once
+ *    per aborted attempt.  A commit handler left over from an aborted
+ *    attempt, or an abort handler left over from a committed transaction,
+ *    makes a count too high.
+ */
+
+/*** most forced restarts in one transaction */
+const uint32_t MAX_RESTARTS = 3;
+
+/*** per-thread counts, padded so that threads do not share lines */
+struct handler_counts_t
+{
+    uint64_t commit_runs;   // by the commit handlers
+    uint64_t abort_runs;    // by the abort handlers
+    uint64_t commits;       // transactions that committed
+    uint64_t aborts;        // attempts that did not commit
+    char     pad[64 - 4 * sizeof(uint64_t)];
+};
+
+handler_counts_t counts[stm::MAX_THREADS];
+
+/*** the shared counter, incremented once per commit */
+intptr_t total = 0;
+
+/*** transactions whose handler counts were wrong; any is a failure */
+volatile uint32_t check_failures = 0;
+
+/*** the handlers */
+void count_commit(void* arg)
+{
+    ++static_cast<handler_counts_t*>(arg)->commit_runs;
+}
+
+void count_abort(void* arg)
+{
+    ++static_cast<handler_counts_t*>(arg)->abort_runs;
+}
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Nothing to build */
+void bench_init()
+{
+}
+
+/*** Run one transaction, and check the handler counts */
+void bench_test(uintptr_t id, uint32_t* seed)
+{
+    handler_counts_t* c = &counts[id];
+    uint32_t restarts = rand_r(seed) % (MAX_RESTARTS + 1);
+    // NB: volatile needed because using a non-volatile local in
+    //     conjunction with a setjmp-longjmp control transfer is undefined
+    volatile uint32_t attempts = 0;
+    TM_BEGIN(atomic) {
+        ++attempts;
+        stm::on_commit(count_commit, c);
+        stm::on_abort(count_abort, c);
+        TM_WRITE(total, TM_READ(total) + 1);
+        // algorithms that never abort cannot restart
+        if ((attempts <= restarts) && !stm::is_irrevoc(*tx))
+            stm::restart();
+    } TM_END;
+
+    ++c->commits;
+    c->aborts += attempts - 1;
+    if ((c->commit_runs != c->commits) || (c->abort_runs != c->aborts))
+        fai32(&check_failures);
+}
+
+/*** Every check passed, and the counter saw every commit */
+bool bench_verify()
+{
+    uint64_t commits = 0;
+    for (uint32_t i = 0; i < stm::MAX_THREADS; ++i)
+        commits += counts[i].commits;
+    if (check_failures)
+        std::cout << "(" << check_failures << " failed checks) ";
+    return (check_failures == 0) && ((uint64_t)total == commits);
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "Handler";
+}
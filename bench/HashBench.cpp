@@ -62,12 +62,12 @@ void bench_init()
 }
 
 /*** Run a bunch of increment transactions */
-void bench_test(uintptr_t, uint32_t* seed)
+void bench_test(uintptr_t id, uint32_t* seed)
 {
-    uint32_t val = rand_r(seed) % CFG.elements;
+    uint32_t val = KEYS.next(id, seed);
     uint32_t act = rand_r(seed) % 100;
     if (act < CFG.lookpct) {
-        TM_BEGIN(atomic) {
+        TM_BEGIN(readonly) {
             SET->lookup(val TM_PARAM);
         } TM_END;
     }
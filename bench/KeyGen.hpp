@@ -0,0 +1,221 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#ifndef KEYGEN_HPP__
+#define KEYGEN_HPP__
+
+#include <stdint.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ *  Key generator for the set benchmarks.  The distribution is chosen with a
+ *  spec string (the -K flag):
+ *
+ *    uniform             - rand_r() % range, as the benchmarks always did
+ *    zipf[:theta]        - rank r is drawn with weight 1/(r+1)^theta
+ *                          (default theta 0.99)
+ *    hotspot[:x[:y]]     - x% of draws go to y% of the keys, the rest are
+ *                          uniform over the others (default 80:20)
+ *    sequential          - each thread walks the key range in order
+ *    latest[:theta]      - zipf, counted backwards from a frontier that
+ *                          advances by one key per draw, so the hot keys are
+ *                          always the most recently visited ones
+ *
+ *  For zipf and hotspot, ranks are scattered over the key range with a
+ *  multiplicative permutation, so that the hot keys are not all at the head
+ *  of a list or in one subtree.
+ *
+ *  All of the floating-point work happens in configure(): zipf and latest
+ *  build a Walker alias table, after which a draw is two rand_r() calls, a
+ *  compare and a couple of loads.  This keeps key generation cheap enough to
+ *  do inside a transaction, as ForestBench does.
+ */
+class KeyGen
+{
+    enum dist_t { UNIFORM, ZIPF, HOTSPOT, SEQUENTIAL, LATEST };
+
+    /*** a per-thread cursor, padded to avoid false sharing */
+    struct cursor_t
+    {
+        uint32_t next;
+        char     pad[64 - sizeof(uint32_t)];
+    };
+
+    /*** a large prime, for permuting ranks into keys */
+    static const uint64_t SCATTER = 2654435761ULL;
+
+    dist_t                dist;
+    std::string           spec;
+    uint32_t              range;
+    double                theta;        // zipf/latest skew
+    uint32_t              hot_pct;      // hotspot: % of draws that are hot
+    uint32_t              hot_keys;     // hotspot: size of the hot set
+    std::vector<uint32_t> prob;         // alias table: P(keep) * 2^31
+    std::vector<uint32_t> alias;        // alias table: the alternative
+    cursor_t              cursors[256];
+
+    /*** map a rank to a key */
+    uint32_t scatter(uint32_t rank) const
+    {
+        return (uint32_t)((rank * SCATTER) % range);
+    }
+
+    /*** draw a zipf rank in O(1) from the alias table */
+    uint32_t zipf_rank(uint32_t* seed) const
+    {
+        uint32_t i = rand_r(seed) % range;
+        return ((uint32_t)rand_r(seed) < prob[i]) ? i : alias[i];
+    }
+
+    /**
+     *  Build the alias table for weights 1/(r+1)^theta with Vose's method:
+     *  every column holds its own rank with probability prob[i], and tops up
+     *  the remainder from one 'large' rank.
+     */
+    void build_alias()
+    {
+        std::vector<double> w(range);
+        double sum = 0;
+        for (uint32_t r = 0; r < range; ++r)
+            sum += (w[r] = 1.0 / pow(r + 1.0, theta));
+        std::vector<uint32_t> small, large;
+        for (uint32_t r = 0; r < range; ++r) {
+            w[r] = w[r] * range / sum;
+            (w[r] < 1.0 ? small : large).push_back(r);
+        }
+        prob.assign(range, 0x80000000u);
+        alias.resize(range);
+        for (uint32_t r = 0; r < range; ++r)
+            alias[r] = r;
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back(); small.pop_back();
+            uint32_t l = large.back();
+            prob[s] = (uint32_t)(w[s] * 2147483648.0);
+            alias[s] = l;
+            w[l] -= 1.0 - w[s];
+            if (w[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+    }
+
+    /*** parse the number after the next ':' of a spec, if there is one */
+    static bool field(std::istringstream& in, double& out)
+    {
+        std::string f;
+        if (!std::getline(in, f, ':'))
+            return true;
+        char* end;
+        out = strtod(f.c_str(), &end);
+        return (end != f.c_str()) && (*end == '\0');
+    }
+
+  public:
+    KeyGen()
+        : dist(UNIFORM), spec("uniform"), range(1), theta(0.99), hot_pct(80),
+          hot_keys(1), prob(), alias()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+            cursors[i].next = 0;
+    }
+
+    /**
+     *  Set up the distribution described by s, over keys [0, r).  Returns
+     *  false, after printing why, if the spec is not valid.
+     */
+    bool configure(const std::string& s, uint32_t r)
+    {
+        spec = (s == "") ? "uniform" : s;
+        range = r ? r : 1;
+        std::istringstream in(spec);
+        std::string name;
+        std::getline(in, name, ':');
+        bool ok = true;
+
+        if (name == "uniform") {
+            dist = UNIFORM;
+        }
+        else if (name == "zipf" || name == "latest") {
+            dist = (name == "zipf") ? ZIPF : LATEST;
+            ok = field(in, theta) && theta >= 0;
+            if (ok)
+                build_alias();
+        }
+        else if (name == "hotspot") {
+            double x = 80, y = 20;
+            dist = HOTSPOT;
+            ok = field(in, x) && field(in, y) && x >= 0 && x <= 100 &&
+                 y > 0 && y < 100;
+            hot_pct = (uint32_t)x;
+            hot_keys = (uint32_t)(range * y / 100);
+            if (hot_keys == 0)
+                hot_keys = 1;
+            if (hot_keys >= range)
+                hot_keys = range - 1;
+        }
+        else if (name == "sequential") {
+            dist = SEQUENTIAL;
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok)
+            std::cerr << "Invalid key distribution: " << spec << "\n";
+        if (ok && (dist == HOTSPOT) && (range < 2)) {
+            std::cerr << "hotspot needs at least two keys\n";
+            ok = false;
+        }
+
+        // stagger the threads' cursors so that sequential threads do not all
+        // walk in lock step over the same keys
+        for (uint32_t i = 0; i < 256; ++i)
+            cursors[i].next = (uint32_t)(((uint64_t)range * i) / 256);
+        return ok;
+    }
+
+    /*** Draw the next key for thread id */
+    uint32_t next(uintptr_t id, uint32_t* seed)
+    {
+        switch (dist) {
+          case UNIFORM:
+            return rand_r(seed) % range;
+          case ZIPF:
+            return scatter(zipf_rank(seed));
+          case HOTSPOT:
+            if ((uint32_t)(rand_r(seed) % 100) < hot_pct)
+                return scatter(rand_r(seed) % hot_keys);
+            return scatter(hot_keys + rand_r(seed) % (range - hot_keys));
+          case SEQUENTIAL: {
+              uint32_t k = cursors[id].next;
+              cursors[id].next = (k + 1 == range) ? 0 : k + 1;
+              return k;
+          }
+          case LATEST: {
+              uint32_t front = cursors[id].next;
+              cursors[id].next = (front + 1 == range) ? 0 : front + 1;
+              uint32_t back = zipf_rank(seed);
+              return (front >= back) ? front - back : front + range - back;
+          }
+        }
+        return 0;
+    }
+
+    /*** the spec that was configured */
+    const std::string& name() const { return spec; }
+};
+
+#endif // KEYGEN_HPP__
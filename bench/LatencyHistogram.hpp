@@ -0,0 +1,109 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#ifndef LATENCYHISTOGRAM_HPP__
+#define LATENCYHISTOGRAM_HPP__
+
+#include <stdint.h>
+#include <cstring>
+
+/**
+ *  A log-linear histogram of latencies, in the style of HdrHistogram.
+ *
+ *  Values below 2^SUB_BITS get a bucket each.  Above that, every power of two
+ *  is split into 2^SUB_BITS equal buckets, so a recorded value is known to
+ *  within 1/2^SUB_BITS (about 3%) of its true value, over the full 64-bit
+ *  range, in a fixed amount of space.  Recording is a few shifts and an
+ *  increment, so each thread can keep its own histogram on its critical path
+ *  and merge it with the others after the experiment.
+ */
+class LatencyHistogram
+{
+    static const uint32_t SUB_BITS = 5;
+    static const uint32_t SUB_COUNT = 1 << SUB_BITS;
+    static const uint32_t BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t counts[BUCKETS];
+    uint64_t total;
+    uint64_t maxval;
+
+    /*** map a value to its bucket */
+    static uint32_t index(uint64_t v)
+    {
+        if (v < SUB_COUNT)
+            return (uint32_t)v;
+        uint32_t msb = 63 - __builtin_clzll(v);
+        uint32_t shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + (uint32_t)(v >> shift) - SUB_COUNT;
+    }
+
+    /*** the smallest value that maps to a bucket */
+    static uint64_t lowest(uint32_t idx)
+    {
+        if (idx < SUB_COUNT)
+            return idx;
+        uint32_t shift = idx / SUB_COUNT - 1;
+        return ((uint64_t)(idx % SUB_COUNT + SUB_COUNT)) << shift;
+    }
+
+  public:
+    LatencyHistogram() { reset(); }
+
+    void reset()
+    {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        maxval = 0;
+    }
+
+    /*** count one value */
+    void record(uint64_t v)
+    {
+        ++counts[index(v)];
+        ++total;
+        if (v > maxval)
+            maxval = v;
+    }
+
+    /*** fold another histogram into this one */
+    void merge(const LatencyHistogram& h)
+    {
+        for (uint32_t i = 0; i < BUCKETS; ++i)
+            counts[i] += h.counts[i];
+        total += h.total;
+        if (h.maxval > maxval)
+            maxval = h.maxval;
+    }
+
+    /**
+     *  The value at or below which pct percent of the recorded values fall,
+     *  reported as the low end of its bucket (the max is exact)
+     */
+    uint64_t percentile(double pct) const
+    {
+        if (!total)
+            return 0;
+        uint64_t want = (uint64_t)((pct / 100.0) * total + 0.5);
+        if (want == 0)
+            want = 1;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= want)
+                return (lowest(i) < maxval) ? lowest(i) : maxval;
+        }
+        return maxval;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max()   const { return maxval; }
+};
+
+#endif // LATENCYHISTOGRAM_HPP__
@@ -0,0 +1,309 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <api/api.hpp>
+#include <stm/trace.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *    We replay the traces that libstm writes when it is built with
+ *    libstm_enable_trace and run with STM_TRACE=<prefix> (see
+ *    stm/trace.hpp).  -t <prefix> loads <prefix>.1, <prefix>.2, ... as one
+ *    stream of transactions per traced thread.  Only attempts that committed
+ *    are kept: the algorithm under test decides for itself what aborts.
+ *
+ *    Traced addresses are remapped into a private arena a page at a time,
+ *    so that offsets within a page, and thus word alignment, cache line
+ *    sharing and most orec collisions, are the same as in the traced run.
+ *    Reads and writes have the traced sizes; writes store the replaying
+ *    thread's id.
+ *
+ *    Replay thread i runs stream i % (number of streams), from a starting
+ *    point that depends on i / (number of streams), and wraps around at the
+ *    end, so any thread count can replay any set of traces.
+ */
+
+const uintptr_t PAGE_BYTES = 4096;
+
+/*** one replayed access, already remapped into the arena */
+struct replay_op_t
+{
+    uint8_t*  addr;
+    uint32_t  size;             // 4 or 8
+    bool      write;
+};
+
+/*** one committed transaction: a run of ops */
+struct replay_tx_t
+{
+    uint32_t  first;
+    uint32_t  count;
+    bool      readonly;
+};
+
+/*** the transactions of one traced thread */
+struct stream_t
+{
+    std::vector<replay_op_t> ops;
+    std::vector<replay_tx_t> txns;
+};
+
+std::vector<stream_t> streams;
+
+/*** per-thread position in its stream, padded to avoid false sharing */
+struct cursor_t
+{
+    uint32_t next;
+    char     pad[64 - sizeof(uint32_t)];
+};
+
+cursor_t cursors[256];
+
+/*** read one trace file; false if it does not exist */
+bool load_trace(const std::string& name, std::vector<stm::trace_rec_t>& recs)
+{
+    FILE* in = fopen(name.c_str(), "rb");
+    if (!in)
+        return false;
+    stm::trace_header_t h;
+    if ((fread(&h, sizeof(h), 1, in) != 1) ||
+        strncmp(h.magic, "RSTMTRC", sizeof(h.magic)) ||
+        (h.version != stm::TRACE_VERSION) ||
+        (h.rec_bytes != sizeof(stm::trace_rec_t)))
+    {
+        std::cerr << name << " is not a trace file we can read\n";
+        exit(-1);
+    }
+    stm::trace_rec_t r;
+    while (fread(&r, sizeof(r), 1, in) == 1)
+        recs.push_back(r);
+    fclose(in);
+    return true;
+}
+
+/**
+ *  Split the traced range [addr, addr+size) into naturally aligned 8- and
+ *  4-byte accesses, and add them to s.  The API has no smaller barriers, so
+ *  bytes at the ends of a range (from bulk operations) become an access to
+ *  the 4-byte word that contains them.
+ */
+void add_ops(stream_t& s, uint64_t addr, uint32_t size, bool write,
+             const std::vector<uint64_t>& pages, uint8_t* arena)
+{
+    uint64_t end = addr + size;
+    addr &= ~(uint64_t)3;
+    while (addr < end) {
+        uint32_t n = ((addr & 7) || (end - addr < 8)) ? 4 : 8;
+        size_t page = std::lower_bound(pages.begin(), pages.end(),
+                                       addr / PAGE_BYTES) - pages.begin();
+        replay_op_t op;
+        op.addr  = arena + page * PAGE_BYTES + (addr % PAGE_BYTES);
+        op.size  = n;
+        op.write = write;
+        s.ops.push_back(op);
+        addr += n;
+    }
+}
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Load the traces and build the arena */
+void bench_init()
+{
+    if (CFG.trace == "") {
+        std::cerr << "ReplayBench needs a trace prefix (-t)\n";
+        exit(-1);
+    }
+
+    // read every file, and find the pages that the traces touch
+    std::vector<std::vector<stm::trace_rec_t> > files;
+    std::vector<uint64_t> pages;
+    for (uint32_t i = 1; i <= stm::MAX_THREADS; ++i) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%u", i);
+        files.push_back(std::vector<stm::trace_rec_t>());
+        if (!load_trace(CFG.trace + suffix, files.back())) {
+            files.pop_back();
+            break;
+        }
+        for (size_t r = 0; r < files.back().size(); ++r) {
+            const stm::trace_rec_t& rec = files.back()[r];
+            if (((rec.kind() != stm::TRACE_READ) &&
+                 (rec.kind() != stm::TRACE_WRITE)) || !rec.size())
+                continue;
+            for (uint64_t p = rec.addr / PAGE_BYTES;
+                 p <= (rec.addr + rec.size() - 1) / PAGE_BYTES; ++p)
+                if (pages.empty() || (pages.back() != p))
+                    pages.push_back(p);
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "No trace files found at " << CFG.trace << ".1\n";
+        exit(-1);
+    }
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    // a page-aligned arena with one page per traced page
+    uint8_t* raw = (uint8_t*)calloc(pages.size() + 1, PAGE_BYTES);
+    uint8_t* arena = (uint8_t*)(((uintptr_t)raw + PAGE_BYTES - 1) &
+                                ~(PAGE_BYTES - 1));
+
+    // keep the committed attempts of each file
+    size_t total_txns = 0, total_ops = 0;
+    for (size_t f = 0; f < files.size(); ++f) {
+        stream_t s;
+        bool in_tx = false;
+        size_t committed = 0;   // ops that belong to committed attempts
+        replay_tx_t t = { 0, 0, false };
+        for (size_t r = 0; r < files[f].size(); ++r) {
+            const stm::trace_rec_t& rec = files[f][r];
+            switch (rec.kind()) {
+              case stm::TRACE_BEGIN:
+              case stm::TRACE_BEGIN_RO:
+                in_tx = true;
+                s.ops.resize(committed);
+                t.first = committed;
+                t.readonly = (rec.kind() == stm::TRACE_BEGIN_RO);
+                break;
+              case stm::TRACE_READ:
+              case stm::TRACE_WRITE:
+                if (in_tx)
+                    add_ops(s, rec.addr, rec.size(),
+                            rec.kind() == stm::TRACE_WRITE, pages, arena);
+                break;
+              case stm::TRACE_COMMIT:
+                if (in_tx) {
+                    committed = s.ops.size();
+                    t.count = committed - t.first;
+                    s.txns.push_back(t);
+                }
+                in_tx = false;
+                break;
+              case stm::TRACE_ABORT:
+                // drop the attempt; the retry has its own begin
+                s.ops.resize(committed);
+                in_tx = false;
+                break;
+            }
+        }
+        s.ops.resize(committed);
+        if (s.txns.empty())
+            continue;
+        total_txns += s.txns.size();
+        total_ops += s.ops.size();
+        streams.push_back(s);
+    }
+    if (streams.empty()) {
+        std::cerr << "The traces have no committed transactions\n";
+        exit(-1);
+    }
+
+    // threads that share a stream start at different points in it
+    for (uint32_t i = 0; i < 256; ++i) {
+        const stream_t& s = streams[i % streams.size()];
+        cursors[i].next = (uint32_t)(((uint64_t)(i / streams.size()) *
+                                      s.txns.size()) / 8 % s.txns.size());
+    }
+
+    std::cout << "Replaying " << total_txns << " transactions (" << total_ops
+              << " accesses) from " << streams.size() << " of "
+              << files.size() << " trace files over " << pages.size()
+              << " pages\n";
+}
+
+/*** Replay the next transaction of this thread's stream */
+void bench_test(uintptr_t id, uint32_t*)
+{
+    const stream_t& s = streams[id % streams.size()];
+    uint32_t next = cursors[id].next;
+    cursors[id].next = (next + 1 == s.txns.size()) ? 0 : next + 1;
+    const replay_tx_t& t = s.txns[next];
+    const replay_op_t* ops = &s.ops[t.first];
+
+    // NB: volatile needed because using a non-volatile local in
+    //     conjunction with a setjmp-longjmp control transfer is undefined
+    volatile uint64_t sink = 0;
+    if (t.readonly) {
+        TM_BEGIN(readonly) {
+            for (uint32_t i = 0; i < t.count; ++i) {
+                if (ops[i].size == 4)
+                    sink += TM_READ(*(uint32_t*)ops[i].addr);
+                else
+                    sink += TM_READ(*(uint64_t*)ops[i].addr);
+            }
+        } TM_END;
+    }
+    else {
+        TM_BEGIN(atomic) {
+            for (uint32_t i = 0; i < t.count; ++i) {
+                uint8_t* a = ops[i].addr;
+                if (ops[i].write && (ops[i].size == 4))
+                    TM_WRITE(*(uint32_t*)a, (uint32_t)id);
+                else if (ops[i].write)
+                    TM_WRITE(*(uint64_t*)a, (uint64_t)id);
+                else if (ops[i].size == 4)
+                    sink += TM_READ(*(uint32_t*)a);
+                else
+                    sink += TM_READ(*(uint64_t*)a);
+            }
+        } TM_END;
+    }
+    (void)sink;
+}
+
+/*** A replay has no invariants of its own */
+bool bench_verify() { return true; }
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "Replay";
+}
@@ -0,0 +1,212 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#ifndef SKIPLIST_HPP__
+#define SKIPLIST_HPP__
+
+#include <cstddef>
+#include <api/api.hpp> // need this for malloc and free
+
+// Set of integers represented as a skiplist.  A node is promoted to each
+// successive level with probability 1/fanout.  To keep the transactional
+// code free of random number state, a node's height is a hash of its value,
+// so a key always gets the same height no matter when it is inserted.
+class SkipList
+{
+    static const int MAX_LEVEL = 32;
+
+    // Node in a SkipList.  Only the first m_height entries of m_next are
+    // allocated.
+    struct Node
+    {
+        int   m_val;
+        int   m_height;
+        Node* m_next[MAX_LEVEL];
+    };
+
+    // bytes needed for a node with 'height' levels
+    static size_t nodeSize(int height)
+    {
+        return offsetof(Node, m_next) + height * sizeof(Node*);
+    }
+
+    uint32_t m_fanout;      // 1/promotion probability
+    int      m_levels;      // levels in use, fixed at construction
+    Node*    m_head;        // sentinel with m_levels next pointers
+
+    // deterministic height of a node holding val
+    TM_CALLABLE
+    int heightOf(int val) const;
+
+    // find the first node whose value is >= val, recording the last node
+    // before it on each level in preds (if preds is not NULL)
+    TM_CALLABLE
+    const Node* find(int val, Node** preds TM_ARG) const;
+
+  public:
+
+    // fanout >= 2 is the promotion ratio, expected is the number of keys
+    // we expect to hold, which bounds the number of levels
+    SkipList(uint32_t fanout, uint32_t expected);
+
+    // true iff val is in the data structure
+    TM_CALLABLE
+    bool lookup(int val TM_ARG) const;
+
+    // standard IntSet methods
+    TM_CALLABLE
+    void insert(int val TM_ARG);
+
+    TM_CALLABLE
+    void remove(int val TM_ARG);
+
+    // count the elements in [lo, hi]
+    TM_CALLABLE
+    uint32_t scan(int lo, int hi TM_ARG) const;
+
+    // make sure every level is sorted, every node is on all of the levels up
+    // to its height, and has the height that its value hashes to
+    bool isSane() const;
+};
+
+// constructor: pick the number of levels, and make a sentinel that is on all
+// of them
+SkipList::SkipList(uint32_t fanout, uint32_t expected)
+    : m_fanout(fanout < 2 ? 2 : fanout), m_levels(1), m_head(NULL)
+{
+    for (uint64_t n = m_fanout; n < expected && m_levels < MAX_LEVEL;
+         n *= m_fanout)
+        ++m_levels;
+    ++m_levels; // one extra, for luck
+    if (m_levels > MAX_LEVEL)
+        m_levels = MAX_LEVEL;
+    m_head = (Node*)malloc(nodeSize(m_levels));
+    m_head->m_val = -1;
+    m_head->m_height = m_levels;
+    for (int l = 0; l < m_levels; ++l)
+        m_head->m_next[l] = NULL;
+}
+
+// hash val, and count how many base-fanout digits of the hash are zero
+TM_CALLABLE
+int SkipList::heightOf(int val) const
+{
+    uint32_t h = (uint32_t)val;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    int height = 1;
+    while (h && (height < m_levels) && (h % m_fanout == 0)) {
+        h /= m_fanout;
+        ++height;
+    }
+    return height;
+}
+
+// standard skiplist search, from the top level down
+TM_CALLABLE
+const SkipList::Node* SkipList::find(int val, Node** preds TM_ARG) const
+{
+    Node* x = m_head;
+    const Node* n = NULL;
+    for (int l = m_levels - 1; l >= 0; --l) {
+        n = TM_READ(x->m_next[l]);
+        while ((n != NULL) && (TM_READ(n->m_val) < val)) {
+            x = const_cast<Node*>(n);
+            n = TM_READ(x->m_next[l]);
+        }
+        if (preds)
+            preds[l] = x;
+    }
+    return n;
+}
+
+// search function
+TM_CALLABLE
+bool SkipList::lookup(int val TM_ARG) const
+{
+    const Node* n = find(val, NULL TM_PARAM);
+    return (n != NULL) && (TM_READ(n->m_val) == val);
+}
+
+// insert method; if val is already in the list, exit without inserting
+TM_CALLABLE
+void SkipList::insert(int val TM_ARG)
+{
+    Node* preds[MAX_LEVEL];
+    const Node* n = find(val, preds TM_PARAM);
+    if ((n != NULL) && (TM_READ(n->m_val) == val))
+        return;
+
+    // the new node is private until we link it in at level 0
+    int height = heightOf(val);
+    Node* i = (Node*)TM_ALLOC(nodeSize(height));
+    i->m_val = val;
+    i->m_height = height;
+    for (int l = 0; l < height; ++l) {
+        i->m_next[l] = TM_READ(preds[l]->m_next[l]);
+        TM_WRITE(preds[l]->m_next[l], i);
+    }
+}
+
+// remove a node if its value == val
+TM_CALLABLE
+void SkipList::remove(int val TM_ARG)
+{
+    Node* preds[MAX_LEVEL];
+    const Node* n = find(val, preds TM_PARAM);
+    if ((n == NULL) || (TM_READ(n->m_val) != val))
+        return;
+
+    // unlink it from every level it is on
+    int height = TM_READ(n->m_height);
+    for (int l = 0; l < height; ++l)
+        TM_WRITE(preds[l]->m_next[l], TM_READ(n->m_next[l]));
+    TM_FREE(const_cast<Node*>(n));
+}
+
+// range scan: find lo, then walk the bottom level
+TM_CALLABLE
+uint32_t SkipList::scan(int lo, int hi TM_ARG) const
+{
+    uint32_t count = 0;
+    const Node* n = find(lo, NULL TM_PARAM);
+    while ((n != NULL) && (TM_READ(n->m_val) <= hi)) {
+        ++count;
+        n = TM_READ(n->m_next[0]);
+    }
+    return count;
+}
+
+// sanity check: each level is sorted, and is a subsequence of the level below
+bool SkipList::isSane() const
+{
+    for (int l = 0; l < m_levels; ++l) {
+        const Node* below = m_head;
+        const Node* prev = m_head;
+        for (const Node* n = m_head->m_next[l]; n != NULL; n = n->m_next[l]) {
+            if ((n->m_val <= prev->m_val) || (n->m_height <= l) ||
+                (n->m_height != heightOf(n->m_val)))
+                return false;
+            if (l > 0) {
+                while ((below != NULL) && (below != n))
+                    below = below->m_next[l - 1];
+                if (below == NULL)
+                    return false;
+            }
+            prev = n;
+        }
+    }
+    return true;
+}
+
+#endif // SKIPLIST_HPP__
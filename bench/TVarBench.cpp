@@ -0,0 +1,161 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <iostream>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *    This is BankBench with every account in a tvar<intptr_t>, so that it
+ *    exercises the per-object barriers (TM_READ_TVAR/TM_WRITE_TVAR): the
+ *    embedded orecs in the OrecEager family, and the fallback to the word
+ *    barriers everywhere else.  Audits read every account, and must always
+ *    see the same total.
+ *
+ *    -R sets the percentage of balance queries, of which -Q percent are
+ *    audits, and the remaining transactions are transfers.  -I percent of
+ *    the transfers become irrevocable before they touch any account, so
+ *    that the irrevocable tvar barriers (concurrent inevitability, in the
+ *    OrecEager family) race with ordinary ones.  Pipeline, PipelineDet,
+ *    CToken and CTokenTurbo cannot become irrevocable, so leave -I at its
+ *    default of 0 for them.
+ */
+
+typedef stm::tvar<intptr_t> account_t;
+
+const intptr_t INITIAL_BALANCE = 1000;
+
+/*** most transfers in one transaction */
+const uint32_t MAX_TRANSFERS = 64;
+
+account_t* accounts;
+
+/*** audits that saw the wrong total; any is a failure */
+volatile uint32_t audit_failures = 0;
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Open all the accounts */
+void bench_init()
+{
+    accounts = new account_t[CFG.elements];
+    for (uint32_t i = 0; i < CFG.elements; ++i)
+        accounts[i].unsafe_set(INITIAL_BALANCE);
+}
+
+/*** Run an audit, a balance query, or some transfers */
+void bench_test(uintptr_t id, uint32_t* seed)
+{
+    uint32_t act = rand_r(seed) % 100;
+    if (act < CFG.lookpct) {
+        // NB: volatile needed because using a non-volatile local in
+        //     conjunction with a setjmp-longjmp control transfer is undefined
+        volatile intptr_t sum = 0;
+        if (act < CFG.lookpct * CFG.scanpct / 100) {
+            TM_BEGIN(readonly) {
+                sum = 0;
+                for (uint32_t i = 0; i < CFG.elements; ++i)
+                    sum += TM_READ_TVAR(accounts[i]);
+            } TM_END;
+            if (sum != INITIAL_BALANCE * (intptr_t)CFG.elements)
+                fai32(&audit_failures);
+        }
+        else {
+            uint32_t acct = KEYS.next(id, seed);
+            TM_BEGIN(readonly) {
+                sum = TM_READ_TVAR(accounts[acct]);
+            } TM_END;
+        }
+        return;
+    }
+
+    // draw the transfers up front, so that a retry does not advance the key
+    // generator and skew the key distribution
+    bool irrevocable = ((uint32_t)(rand_r(seed) % 100) < CFG.irrevocpct);
+    uint32_t src[MAX_TRANSFERS], dst[MAX_TRANSFERS];
+    intptr_t amount[MAX_TRANSFERS];
+    for (uint32_t i = 0; i < CFG.ops; ++i) {
+        src[i] = KEYS.next(id, seed);
+        dst[i] = (src[i] + 1 + rand_r(seed) % (CFG.elements - 1))
+               % CFG.elements;
+        amount[i] = 1 + rand_r(seed) % 100;
+    }
+    TM_BEGIN(atomic) {
+        if (irrevocable)
+            TM_BECOME_IRREVOC();
+        for (uint32_t i = 0; i < CFG.ops; ++i) {
+            intptr_t from = TM_READ_TVAR(accounts[src[i]]);
+            if (from >= amount[i]) {
+                TM_WRITE_TVAR(accounts[src[i]], from - amount[i]);
+                TM_WRITE_TVAR(accounts[dst[i]],
+                              TM_READ_TVAR(accounts[dst[i]]) + amount[i]);
+            }
+        }
+    } TM_END;
+}
+
+/*** Every audit balanced, and so do the books at the end */
+bool bench_verify()
+{
+    intptr_t sum = 0;
+    for (uint32_t i = 0; i < CFG.elements; ++i) {
+        if (accounts[i].unsafe_get() < 0)
+            return false;
+        sum += accounts[i].unsafe_get();
+    }
+    if (audit_failures)
+        std::cout << "(" << audit_failures << " failed audits) ";
+    return (audit_failures == 0) &&
+           (sum == INITIAL_BALANCE * (intptr_t)CFG.elements);
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "TVar";
+    // a transfer needs two distinct accounts
+    if (CFG.elements < 2) CFG.elements = 2;
+    if (CFG.ops > MAX_TRANSFERS) CFG.ops = MAX_TRANSFERS;
+}
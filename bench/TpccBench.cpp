@@ -0,0 +1,303 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <iostream>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *    This is a much-reduced TPC-C: CFG.sets warehouses, each with DISTRICTS
+ *    districts of CFG.elements customers, and stock for ITEMS items.  There
+ *    are three transactions:
+ *
+ *      new-order    - take the district's next order id, update the stock of
+ *                     5-15 items, and record the order.  Each district keeps
+ *                     its last LIVE_ORDERS orders; placing an order delivers
+ *                     the oldest one, which keeps the tables bounded.
+ *      payment      - add a payment to the warehouse, district and customer
+ *                     year-to-date totals.  Every payment to a warehouse
+ *                     writes the same word, as in TPC-C.
+ *      order-status - read-only: find a customer's last order through the
+ *                     order index, and read its lines.
+ *
+ *    Live orders are indexed by a HashTable, and undelivered orders by an
+ *    RBTree, keyed by (district, order id).  Each thread uses the warehouse
+ *    id % CFG.sets as its home warehouse, as TPC-C terminals do.
+ */
+
+#include "Hash.hpp"
+#include "Tree.hpp"
+
+const uint32_t DISTRICTS    = 10;
+const uint32_t ITEMS        = 1000;
+const uint32_t MAX_LINES    = 15;
+const uint32_t LIVE_ORDERS  = 16;
+const uint32_t ORDER_BITS   = 20;       // order id bits in an order key
+const uint32_t MAX_WAREHOUSES = (1u << (31 - ORDER_BITS)) / DISTRICTS;
+
+struct OrderLine
+{
+    intptr_t item;
+    intptr_t quantity;
+    intptr_t amount;
+};
+
+struct Order
+{
+    intptr_t  key;
+    intptr_t  customer;
+    intptr_t  line_cnt;
+    OrderLine lines[MAX_LINES];
+};
+
+struct Warehouse
+{
+    intptr_t ytd;
+};
+
+struct District
+{
+    intptr_t ytd;
+    intptr_t next_o_id;
+    Order*   orders[LIVE_ORDERS];       // live orders, by o_id % LIVE_ORDERS
+};
+
+struct Customer
+{
+    intptr_t balance;
+    intptr_t ytd_payment;
+    intptr_t payment_cnt;
+    intptr_t last_order;                // key of the last order, or -1
+};
+
+struct Stock
+{
+    intptr_t quantity;
+    intptr_t ytd;
+    intptr_t order_cnt;
+};
+
+Warehouse* warehouses;
+District*  districts;                   // [warehouse][district]
+Customer*  customers;                   // [warehouse][district][customer]
+Stock*     stock;                       // [warehouse][item]
+intptr_t*  prices;                      // [item], read-only
+HashTable* order_index;                 // keys of live orders
+RBTree*    new_orders;                  // keys of undelivered orders
+
+/*** the index key of an order */
+inline int order_key(uint32_t district, intptr_t o_id)
+{
+    return (district << ORDER_BITS) | (o_id & ((1 << ORDER_BITS) - 1));
+}
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Populate the tables */
+void bench_init()
+{
+    uint32_t nd = CFG.sets * DISTRICTS;
+    warehouses = (Warehouse*)calloc(CFG.sets, sizeof(Warehouse));
+    districts = (District*)calloc(nd, sizeof(District));
+    customers = (Customer*)calloc(nd * CFG.elements, sizeof(Customer));
+    stock = (Stock*)calloc(CFG.sets * ITEMS, sizeof(Stock));
+    prices = (intptr_t*)malloc(ITEMS * sizeof(intptr_t));
+    for (uint32_t d = 0; d < nd; ++d)
+        districts[d].next_o_id = 1;
+    for (uint32_t c = 0; c < nd * CFG.elements; ++c)
+        customers[c].last_order = -1;
+    for (uint32_t s = 0; s < CFG.sets * ITEMS; ++s)
+        stock[s].quantity = 10 + s % 91;
+    for (uint32_t i = 0; i < ITEMS; ++i)
+        prices[i] = 1 + i % 100;
+    order_index = new HashTable();
+    new_orders = new RBTree();
+}
+
+/*** Run a new-order, payment, or order-status transaction */
+void bench_test(uintptr_t id, uint32_t* seed)
+{
+    // choose all of the inputs up front, so that retries are identical
+    uint32_t w = id % CFG.sets;
+    uint32_t dist = w * DISTRICTS + rand_r(seed) % DISTRICTS;
+    Customer* cust = &customers[dist * CFG.elements + KEYS.next(id, seed)];
+    uint32_t act = rand_r(seed) % 100;
+
+    if (act < CFG.lookpct) {
+        // order-status
+        volatile intptr_t total = 0;
+        TM_BEGIN(readonly) {
+            total = TM_READ(cust->balance);
+            intptr_t key = TM_READ(cust->last_order);
+            if ((key >= 0) && order_index->lookup(key TM_PARAM)) {
+                new_orders->lookup(key TM_PARAM);
+                District* d = &districts[key >> ORDER_BITS];
+                Order* o = TM_READ(d->orders[(key & ((1 << ORDER_BITS) - 1))
+                                             % LIVE_ORDERS]);
+                if ((o != NULL) && (TM_READ(o->key) == key)) {
+                    intptr_t lines = TM_READ(o->line_cnt);
+                    for (intptr_t l = 0; l < lines; ++l)
+                        total += TM_READ(o->lines[l].amount);
+                }
+            }
+        } TM_END;
+    }
+    else if (act < CFG.inspct) {
+        // new-order
+        uint32_t lines = 5 + rand_r(seed) % (MAX_LINES - 4);
+        uint32_t items[MAX_LINES], qtys[MAX_LINES];
+        for (uint32_t l = 0; l < lines; ++l) {
+            items[l] = rand_r(seed) % ITEMS;
+            qtys[l] = 1 + rand_r(seed) % 10;
+        }
+        intptr_t c = cust - customers;
+        TM_BEGIN(atomic) {
+            District* d = &districts[dist];
+            intptr_t o_id = TM_READ(d->next_o_id);
+            TM_WRITE(d->next_o_id, o_id + 1);
+            int key = order_key(dist, o_id);
+
+            // the order is private until we publish it in d->orders
+            Order* o = (Order*)TM_ALLOC(sizeof(Order));
+            o->key = key;
+            o->customer = c;
+            o->line_cnt = lines;
+            for (uint32_t l = 0; l < lines; ++l) {
+                Stock* s = &stock[w * ITEMS + items[l]];
+                intptr_t qty = qtys[l];
+                intptr_t q = TM_READ(s->quantity);
+                q = (q >= qty + 10) ? q - qty : q - qty + 91;
+                TM_WRITE(s->quantity, q);
+                TM_WRITE(s->ytd, TM_READ(s->ytd) + qty);
+                TM_WRITE(s->order_cnt, TM_READ(s->order_cnt) + 1);
+                o->lines[l].item = items[l];
+                o->lines[l].quantity = qty;
+                o->lines[l].amount = qty * prices[items[l]];
+            }
+
+            // deliver the oldest live order, whose slot we are taking
+            Order* old = TM_READ(d->orders[o_id % LIVE_ORDERS]);
+            if (old != NULL) {
+                int okey = TM_READ(old->key);
+                new_orders->remove(okey TM_PARAM);
+                order_index->remove(okey TM_PARAM);
+                TM_FREE(old);
+            }
+            TM_WRITE(d->orders[o_id % LIVE_ORDERS], o);
+            new_orders->insert(key TM_PARAM);
+            order_index->insert(key TM_PARAM);
+            TM_WRITE(cust->last_order, (intptr_t)key);
+        } TM_END;
+    }
+    else {
+        // payment
+        intptr_t amount = 1 + rand_r(seed) % 5000;
+        TM_BEGIN(atomic) {
+            TM_WRITE(warehouses[w].ytd, TM_READ(warehouses[w].ytd) + amount);
+            District* d = &districts[dist];
+            TM_WRITE(d->ytd, TM_READ(d->ytd) + amount);
+            TM_WRITE(cust->balance, TM_READ(cust->balance) - amount);
+            TM_WRITE(cust->ytd_payment, TM_READ(cust->ytd_payment) + amount);
+            TM_WRITE(cust->payment_cnt, TM_READ(cust->payment_cnt) + 1);
+        } TM_END;
+    }
+}
+
+/**
+ *  Check the TPC-C consistency conditions that apply: warehouse totals match
+ *  their districts, district totals match their customers, and exactly the
+ *  live orders of each district are in its slots and in both indexes
+ */
+bool bench_verify()
+{
+    if (!order_index->isSane() || !new_orders->isSane())
+        return false;
+
+    bool ok = true;
+    TM_BEGIN_FAST_INITIALIZATION();
+    for (uint32_t w = 0; w < CFG.sets; ++w) {
+        intptr_t wytd = 0;
+        for (uint32_t dist = w * DISTRICTS; dist < (w + 1) * DISTRICTS; ++dist) {
+            District* d = &districts[dist];
+            wytd += d->ytd;
+
+            intptr_t cytd = 0;
+            for (uint32_t c = 0; c < CFG.elements; ++c)
+                cytd += customers[dist * CFG.elements + c].ytd_payment;
+            ok = ok && (cytd == d->ytd);
+
+            intptr_t placed = d->next_o_id - 1;
+            intptr_t live = (placed < (intptr_t)LIVE_ORDERS) ? placed
+                                                             : LIVE_ORDERS;
+            for (intptr_t o_id = d->next_o_id - live; o_id < d->next_o_id;
+                 ++o_id) {
+                int key = order_key(dist, o_id);
+                Order* o = d->orders[o_id % LIVE_ORDERS];
+                ok = ok && (o != NULL) && (o->key == key) &&
+                     order_index->lookup(key TM_PARAM) &&
+                     new_orders->lookup(key TM_PARAM);
+            }
+            // the last delivered order is gone from both indexes
+            if (placed > (intptr_t)LIVE_ORDERS) {
+                int key = order_key(dist, d->next_o_id - live - 1);
+                ok = ok && !order_index->lookup(key TM_PARAM) &&
+                     !new_orders->lookup(key TM_PARAM);
+            }
+        }
+        ok = ok && (wytd == warehouses[w].ytd);
+    }
+    TM_END_FAST_INITIALIZATION();
+    return ok;
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "TPCC";
+    // -S is the number of warehouses, -m the customers per district
+    if (CFG.sets == 0) CFG.sets = 1;
+    if (CFG.sets > MAX_WAREHOUSES) CFG.sets = MAX_WAREHOUSES;
+    if (CFG.elements == 0) CFG.elements = 1;
+}
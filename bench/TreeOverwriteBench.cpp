@@ -63,9 +63,9 @@ void bench_init()
 }
 
 /*** Run a bunch of random transactions */
-void bench_test(uintptr_t, uint32_t* seed)
+void bench_test(uintptr_t id, uint32_t* seed)
 {
-    uint32_t val = rand_r(seed) % CFG.elements;
+    uint32_t val = KEYS.next(id, seed);
     TM_BEGIN(atomic) {
         SET->modify(val TM_PARAM);
     } TM_END;
@@ -14,6 +14,7 @@
 #include <stm/config.h>
 #include <stdint.h>
 #include <iostream>
+#include "KeyGen.hpp"
 
 /**
  * Standard benchmark configuration globals
@@ -31,6 +32,17 @@ struct Config
     uint32_t    inspct;                 // insert percent
     uint32_t    sets;                   // number of sets to create
     uint32_t    ops;                    // operations per transaction
+    uint32_t    warmup;                 // in seconds, before the trials
+    uint32_t    trials;                 // number of measured runs
+    bool        latency;                // record per-txn latencies
+    std::string keydist;                // key distribution spec
+    uint32_t    fanout;                 // node fan-out of index structures
+    uint32_t    scanpct;                // range scan percent (of lookups)
+    uint32_t    scanlen;                // keys covered by a range scan
+    uint32_t    irrevocpct;             // irrevocable percent (of writers)
+    uint32_t    rate;                   // offered txns/sec, 0 = closed loop
+    bool        poisson;                // Poisson (vs. constant) arrivals
+    std::string trace;                  // trace prefix, for ReplayBench
 
     /*** THESE GET UPDATED LATER ***/
     volatile uint64_t time;
@@ -42,6 +54,9 @@ struct Config
 
 extern Config CFG TM_ALIGN(64);
 
+/*** Key generator for set benchmarks, configured from CFG.keydist */
+extern KeyGen KEYS;
+
 /** BENCHMARKS IMPLEMENT THE FOLLOWING FUNCTIONS */
 
 /*** Initialize the counter */
@@ -12,13 +12,20 @@
 #define BMHARNESS_HPP__
 
 #include <cstdlib>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <vector>
 #include <signal.h>
 #include <pthread.h>
 #include <api/api.hpp>
+#include <stm/perf.hpp>
 #include <common/platform.hpp>
 #include <common/locks.hpp>
 #include "bmconfig.hpp"
+#include "LatencyHistogram.hpp"
+#include "bmplacement.hpp"
 
 using std::string;
 using std::cout;
@@ -34,6 +41,17 @@ Config::Config() :
     inspct(66),
     sets(1),
     ops(1),
+    warmup(0),
+    trials(1),
+    latency(false),
+    keydist("uniform"),
+    fanout(16),
+    scanpct(10),
+    scanlen(64),
+    irrevocpct(0),
+    rate(0),
+    poisson(true),
+    trace(""),
     time(0),
     running(true),
     txcount(0)
@@ -42,25 +60,292 @@ Config::Config() :
 
 Config CFG TM_ALIGN(64);
 
+KeyGen KEYS;
+
 namespace
 {
+  /*** throughput (txns/sec) of each measured trial */
+  std::vector<double> trial_tput;
+
+  /*** per-thread latency histograms */
+  LatencyHistogram* histograms[256] = {NULL};
+
+  /*** algorithms, thread counts and offered loads to sweep over */
+  std::vector<std::string> sweep_algs;
+  std::vector<uint32_t>    sweep_threads;
+  std::vector<uint32_t>    sweep_rates;
+
+  /*** number of threads created, which is the largest count in a sweep */
+  uint32_t workers = 0;
+
+  /*** true when the running algorithm is PipelineDet, whose order we join */
+  bool det_order = false;
+
+  /*** requested thread and memory placement policies (-a and -n) */
+  std::string affinity_policy;
+  std::string numa_policy;
+  Placement   placement;
+
+  /*** the result of one (algorithm, thread count) cell of a sweep */
+  struct cell_t
+  {
+      std::string alg;
+      uint32_t    threads;
+      uint32_t    rate;
+      double      throughput;
+      uint64_t    p99;
+      bool        verified;
+  };
+  std::vector<cell_t> cells;
+
+  /*** txns completed in the current phase, and its start and elapsed times */
+  volatile uint32_t phase_txns = 0;
+  uint64_t phase_start = 0;
+  uint64_t phase_time = 0;
+
+  /**
+   *  In open-loop mode, arrivals that were due before the end of a phase but
+   *  never started, for the current phase and summed over measured trials
+   */
+  volatile uint32_t phase_backlog = 0;
+  uint64_t backlog = 0;
+
+#if defined(STM_PERF) && !defined(STM_API_CXXTM)
+  /**
+   *  Per-phase performance counters (see stm/perf.hpp) at the start of the
+   *  current phase, and their growth summed over measured trials.  Threads
+   *  waiting at a barrier are charged to PERF_NONTX.
+   */
+  stm::perf_totals_t perf_start;
+  stm::perf_totals_t perf_sum;
+  bool perf_valid = false;
+
+  /*** add the growth of the counters since perf_start to perf_sum */
+  void perf_accumulate()
+  {
+      stm::perf_totals_t now;
+      if (!stm::get_perf_counters(&now))
+          return;
+      for (int p = 0; p < stm::PERF_PHASES; ++p) {
+          perf_sum.entries[p] += now.entries[p] - perf_start.entries[p];
+          for (int c = 0; c < stm::PERF_COUNTERS; ++c)
+              perf_sum.value[p][c] += now.value[p][c] - perf_start.value[p][c];
+      }
+      for (int c = 0; c < stm::PERF_COUNTERS; ++c)
+          perf_sum.available[c] = now.available[c];
+      perf_sum.hw_cycles = now.hw_cycles;
+      perf_valid = true;
+  }
+#endif
+
+  /*** summary statistics over the measured trials */
+  struct trial_stats_t
+  {
+      double mean;
+      double stddev;
+      double min;
+
+      trial_stats_t() : mean(0), stddev(0), min(0)
+      {
+          if (trial_tput.empty())
+              return;
+          min = trial_tput[0];
+          for (size_t i = 0; i < trial_tput.size(); ++i) {
+              mean += trial_tput[i];
+              if (trial_tput[i] < min)
+                  min = trial_tput[i];
+          }
+          mean /= trial_tput.size();
+          if (trial_tput.size() > 1) {
+              for (size_t i = 0; i < trial_tput.size(); ++i)
+                  stddev += (trial_tput[i] - mean) * (trial_tput[i] - mean);
+              stddev = sqrt(stddev / (trial_tput.size() - 1));
+          }
+      }
+  };
+
+  /*** merge the histograms of the threads in the last experiment */
+  LatencyHistogram* merged_latency()
+  {
+      static LatencyHistogram total;
+      total.reset();
+      for (uint32_t i = 0; i < CFG.threads; ++i)
+          total.merge(*histograms[i]);
+      return &total;
+  }
+
+  /*** forget the results of the last experiment */
+  void reset_results()
+  {
+      trial_tput.clear();
+      CFG.txcount = 0;
+      CFG.time = 0;
+      backlog = 0;
+#if defined(STM_PERF) && !defined(STM_API_CXXTM)
+      memset(&perf_sum, 0, sizeof(perf_sum));
+      perf_valid = false;
+#endif
+      if (CFG.latency)
+          for (uint32_t i = 0; i < CFG.threads; ++i)
+              histograms[i]->reset();
+  }
 
   /**
    * Print benchmark configuration output
    */
-  void dump_csv()
+  void dump_csv(const char* alg)
   {
       // csv output
       std::cout << "csv"
-                << ", ALG=" << TM_GET_ALGNAME()
+                << ", ALG=" << alg
                 << ", B=" << CFG.bmname     << ", R=" << CFG.lookpct
                 << ", d=" << CFG.duration   << ", p=" << CFG.threads
                 << ", X=" << CFG.execute    << ", m=" << CFG.elements
                 << ", S=" << CFG.sets       << ", O=" << CFG.ops
                 << ", txns=" << CFG.txcount << ", time=" << CFG.time
                 << ", throughput="
-                << (1000000000LL * CFG.txcount) / (CFG.time)
-                << std::endl;
+                << (1000000000LL * CFG.txcount) / (CFG.time);
+
+      // only widen the line when the new options are in use, so that
+      // existing scripts keep parsing it
+      if (CFG.keydist != "uniform")
+          std::cout << ", K=" << CFG.keydist;
+      if (CFG.trials > 1 || CFG.warmup) {
+          trial_stats_t st;
+          std::cout << ", W=" << CFG.warmup << ", T=" << CFG.trials
+                    << ", mean=" << (uint64_t)st.mean
+                    << ", stddev=" << (uint64_t)st.stddev
+                    << ", min=" << (uint64_t)st.min;
+      }
+      if (CFG.latency) {
+          LatencyHistogram* h = merged_latency();
+          std::cout << ", p50=" << h->percentile(50)
+                    << ", p99=" << h->percentile(99)
+                    << ", p999=" << h->percentile(99.9)
+                    << ", max=" << h->max();
+      }
+      if (CFG.rate)
+          std::cout << ", r=" << CFG.rate
+                    << ", i=" << (CFG.poisson ? "poisson" : "constant")
+                    << ", backlog=" << backlog;
+      if (placement.active())
+          std::cout << placement.csv(CFG.threads);
+      std::cout << std::endl;
+  }
+
+  /**
+   *  Print the same results as a single-line JSON object.  Latencies are in
+   *  nanoseconds, and are null when -L was not given.
+   */
+  void dump_json(const char* alg)
+  {
+      trial_stats_t st;
+      std::cout << "{\"alg\": \"" << alg << "\""
+                << ", \"bench\": \"" << CFG.bmname << "\""
+                << ", \"config\": {\"R\": " << CFG.lookpct
+                << ", \"d\": " << CFG.duration
+                << ", \"p\": " << CFG.threads
+                << ", \"X\": " << CFG.execute
+                << ", \"m\": " << CFG.elements
+                << ", \"S\": " << CFG.sets
+                << ", \"O\": " << CFG.ops
+                << ", \"N\": " << CFG.nops_after_tx
+                << ", \"W\": " << CFG.warmup
+                << ", \"T\": " << CFG.trials
+                << ", \"K\": \"" << CFG.keydist << "\""
+                << ", \"F\": " << CFG.fanout
+                << ", \"Q\": " << CFG.scanpct
+                << ", \"G\": " << CFG.scanlen
+                << ", \"I\": " << CFG.irrevocpct << "}"
+                << ", \"placement\": " << placement.json(CFG.threads)
+                << ", \"open_loop\": ";
+      if (CFG.rate)
+          std::cout << "{\"offered\": " << CFG.rate
+                    << ", \"arrivals\": \""
+                    << (CFG.poisson ? "poisson" : "constant") << "\""
+                    << ", \"sustained\": " << (uint64_t)st.mean
+                    << ", \"backlog\": " << backlog << "}";
+      else
+          std::cout << "null";
+      std::cout
+                << ", \"txns\": " << CFG.txcount
+                << ", \"time_ns\": " << CFG.time
+                << ", \"trials\": [";
+      for (size_t i = 0; i < trial_tput.size(); ++i)
+          std::cout << (i ? ", " : "") << (uint64_t)trial_tput[i];
+      std::cout << "]"
+                << ", \"throughput\": {\"mean\": " << (uint64_t)st.mean
+                << ", \"stddev\": " << (uint64_t)st.stddev
+                << ", \"min\": " << (uint64_t)st.min << "}"
+                << ", \"latency_ns\": ";
+      if (CFG.latency) {
+          LatencyHistogram* h = merged_latency();
+          std::cout << "{\"count\": " << h->count()
+                    << ", \"p50\": " << h->percentile(50)
+                    << ", \"p99\": " << h->percentile(99)
+                    << ", \"p99.9\": " << h->percentile(99.9)
+                    << ", \"max\": " << h->max() << "}";
+      }
+      else {
+          std::cout << "null";
+      }
+      std::cout << ", \"perf\": ";
+#if defined(STM_PERF) && !defined(STM_API_CXXTM)
+      if (perf_valid) {
+          std::cout << "{\"cycles_source\": \""
+                    << (perf_sum.hw_cycles ? "pmu" : "tick") << "\""
+                    << ", \"phases\": {";
+          for (int p = 0; p < stm::PERF_PHASES; ++p) {
+              std::cout << (p ? ", " : "") << "\""
+                        << stm::perf_phase_names[p] << "\": {";
+              for (int c = 0; c < stm::PERF_COUNTERS; ++c) {
+                  std::cout << "\"" << stm::perf_counter_names[c] << "\": ";
+                  if (perf_sum.available[c])
+                      std::cout << perf_sum.value[p][c];
+                  else
+                      std::cout << "null";
+                  std::cout << ", ";
+              }
+              std::cout << "\"entries\": " << perf_sum.entries[p] << "}";
+          }
+          std::cout << "}}";
+      }
+      else
+#endif
+          std::cout << "null";
+      std::cout << "}" << std::endl;
+  }
+
+  /**
+   *  After a sweep, print one row per algorithm and one column per thread
+   *  count (and offered load, in open-loop mode): mean throughput, and p99
+   *  latency if it was recorded.  Cells that failed verification are marked
+   *  with a '!'.
+   */
+  void dump_matrix()
+  {
+      const char* metrics[2] = { "throughput", "p99_ns" };
+      size_t cols = sweep_threads.size() * sweep_rates.size();
+      for (int m = 0; m < (CFG.latency ? 2 : 1); ++m) {
+          std::cout << "matrix, B=" << CFG.bmname << ", " << metrics[m]
+                    << "\nALG";
+          for (size_t c = 0; c < cols; ++c) {
+              std::cout << ", p=" << cells[c].threads;
+              if (cells[c].rate)
+                  std::cout << "@r=" << cells[c].rate;
+          }
+          std::cout << "\n";
+          for (size_t c = 0; c < cells.size(); ++c) {
+              if (c % cols == 0)
+                  std::cout << cells[c].alg;
+              std::cout << ", "
+                        << (m ? cells[c].p99 : (uint64_t)cells[c].throughput)
+                        << (cells[c].verified ? "" : "!");
+              if (c % cols == cols - 1)
+                  std::cout << "\n";
+          }
+      }
+      std::cout << std::flush;
   }
 
   /**
@@ -78,6 +363,24 @@ namespace
       std::cerr << "    -B: name of benchmark\n";
       std::cerr << "    -S: number of sets to build (default 1)\n";
       std::cerr << "    -O: operations per transaction (default 1)\n";
+      std::cerr << "    -W: seconds of unmeasured warmup (default 0)\n";
+      std::cerr << "    -T: number of measured trials (default 1)\n";
+      std::cerr << "    -L: record per-transaction latency percentiles\n";
+      std::cerr << "    -A: sweep over a comma-separated list of algorithms\n";
+      std::cerr << "    -P: sweep over a comma-separated list of thread counts\n";
+      std::cerr << "    -K: key distribution: uniform, zipf[:theta],\n"
+                << "        hotspot[:x%ops[:y%keys]], sequential, latest[:theta]\n";
+      std::cerr << "    -F: node fan-out, for SkipList and BPTree (default 16)\n";
+      std::cerr << "    -Q: % range scans, taken from the lookups (default 10)\n";
+      std::cerr << "    -G: keys covered by a range scan (default 64)\n";
+      std::cerr << "    -I: % of writing txns that become irrevocable, for\n"
+                << "        benchmarks that support it (default 0)\n";
+      std::cerr << "    -r: open loop at a comma-separated list of offered loads\n"
+                << "        (txns/sec, across all threads); implies -L\n";
+      std::cerr << "    -i: open-loop arrivals: poisson (default) or constant\n";
+      std::cerr << "    -t: trace file prefix to replay (ReplayBench)\n";
+      std::cerr << "    -a: pin threads (compact, scatter, or a cpu list)\n";
+      std::cerr << "    -n: NUMA policy for bench_init (local, interleave, or a node)\n";
       std::cerr << "    -h: print help (this message)\n\n";
   }
 
@@ -89,7 +392,8 @@ parseargs(int argc, char** argv)
 {
     // parse the command-line options
     int opt;
-    while ((opt = getopt(argc, argv, "N:d:p:hX:B:m:R:S:O:")) != -1) {
+    std::string item;
+    while ((opt = getopt(argc, argv, "N:d:p:hX:B:m:R:S:O:W:T:LA:P:a:n:K:F:Q:G:I:r:i:t:")) != -1) {
         switch(opt) {
           case 'd': CFG.duration      = strtol(optarg, NULL, 10); break;
           case 'p': CFG.threads       = strtol(optarg, NULL, 10); break;
@@ -99,6 +403,36 @@ parseargs(int argc, char** argv)
           case 'm': CFG.elements      = strtol(optarg, NULL, 10); break;
           case 'S': CFG.sets          = strtol(optarg, NULL, 10); break;
           case 'O': CFG.ops           = strtol(optarg, NULL, 10); break;
+          case 'W': CFG.warmup        = strtol(optarg, NULL, 10); break;
+          case 'T': CFG.trials        = strtol(optarg, NULL, 10); break;
+          case 'L': CFG.latency       = true; break;
+          case 'K': CFG.keydist       = std::string(optarg); break;
+          case 'F': CFG.fanout        = strtol(optarg, NULL, 10); break;
+          case 'Q': CFG.scanpct       = strtol(optarg, NULL, 10); break;
+          case 'G': CFG.scanlen       = strtol(optarg, NULL, 10); break;
+          case 'I': CFG.irrevocpct    = strtol(optarg, NULL, 10); break;
+          case 'a': affinity_policy   = std::string(optarg); break;
+          case 'n': numa_policy       = std::string(optarg); break;
+          case 'A': {
+              std::istringstream list(optarg);
+              while (std::getline(list, item, ','))
+                  sweep_algs.push_back(item);
+              break;
+          }
+          case 'P': {
+              std::istringstream list(optarg);
+              while (std::getline(list, item, ','))
+                  sweep_threads.push_back(strtol(item.c_str(), NULL, 10));
+              break;
+          }
+          case 'r': {
+              std::istringstream list(optarg);
+              while (std::getline(list, item, ','))
+                  sweep_rates.push_back(strtol(item.c_str(), NULL, 10));
+              break;
+          }
+          case 't': CFG.trace         = std::string(optarg); break;
+          case 'i': CFG.poisson = (std::string(optarg) != "constant"); break;
           case 'R':
             CFG.lookpct = strtol(optarg, NULL, 10);
             CFG.inspct = (100 - CFG.lookpct)/2 + strtol(optarg, NULL, 10);
@@ -107,6 +441,18 @@ parseargs(int argc, char** argv)
             usage();
         }
     }
+
+    // there must be at least one measured trial
+    if (CFG.trials == 0)
+        CFG.trials = 1;
+
+    // open-loop runs are about latency, so always record it
+    if (sweep_rates.empty())
+        sweep_rates.push_back(0);
+    CFG.rate = sweep_rates[0];
+    for (size_t i = 0; i < sweep_rates.size(); ++i)
+        if (sweep_rates[i])
+            CFG.latency = true;
 }
 
 /**
@@ -127,64 +473,286 @@ extern "C" void catch_SIGALRM(int) {
 }
 
 /**
- *  Support a few lightweight barriers
+ *  A reusable barrier: the last of 'parties' threads to arrive resets the
+ *  count and starts a new generation, which releases everyone spinning on the
+ *  old one
  */
-void
-barrier(uint32_t which)
+struct barrier_t
 {
-    static volatile uint32_t barriers[16] = {0};
-    CFENCE;
-    fai32(&barriers[which]);
-    while (barriers[which] != CFG.threads) { }
-    CFENCE;
+    volatile uint32_t count;
+    volatile uint32_t generation;
+
+    void wait(uint32_t parties)
+    {
+        CFENCE;
+        uint32_t gen = generation;
+        CFENCE;
+        if (fai32(&count) == parties - 1) {
+            count = 0;
+            CFENCE;
+            generation = gen + 1;
+        }
+        else {
+            while (generation == gen) { }
+        }
+        CFENCE;
+    }
+};
+
+/**
+ *  The threads of an experiment synchronize on phase_barrier.  During a
+ *  sweep, every thread also meets on sweep_barrier between cells, since not
+ *  all of them take part in every cell.
+ */
+barrier_t phase_barrier = {0, 0};
+barrier_t sweep_barrier = {0, 0};
+
+inline void barrier() { phase_barrier.wait(CFG.threads); }
+
+/**
+ *  The open-loop arrival schedule of one thread.  Each thread offers
+ *  CFG.rate / CFG.threads transactions per second, with exponential
+ *  (Poisson) or fixed gaps between arrivals, so that the threads together
+ *  offer CFG.rate.  The schedule does not depend on how long transactions
+ *  take: a thread that falls behind runs its overdue transactions back to
+ *  back.
+ */
+struct arrivals_t
+{
+    uint64_t start;     // start of the phase
+    double   gap;       // mean ns between arrivals
+    double   offset;    // ns from start to the next arrival; a double of
+                        // absolute time would lose too much precision
+    uint32_t seed;      // for drawing gaps, separate from the benchmark's
+
+    arrivals_t(uintptr_t id, uint64_t phase_start)
+        : start(phase_start),
+          gap(CFG.rate ? 1000000000.0 * CFG.threads / CFG.rate : 0),
+          offset(0), seed(id ^ 0x5eed)
+    {
+        advance();
+    }
+
+    /*** when the next transaction is due */
+    uint64_t due() const { return start + (uint64_t)offset; }
+
+    void advance()
+    {
+        if (!CFG.poisson) {
+            offset += gap;
+            return;
+        }
+        // inverse transform sampling of an exponential; 1 - u is in (0, 1]
+        double u = rand_r(&seed) / (RAND_MAX + 1.0);
+        offset -= gap * log(1.0 - u);
+    }
+
+    /*** arrivals due at or before 'end' that we have not started */
+    uint32_t overdue(uint64_t end) const
+    {
+        return (due() > end) ? 0 : 1 + (uint32_t)((end - due()) / gap);
+    }
+};
+
+/**
+ *  Run one transaction, timing it if we were given a histogram.  In open-loop
+ *  mode, wait until the next arrival is due first, and measure latency from
+ *  when it was due rather than from when it started, so that time spent
+ *  queued behind slow transactions is counted (no coordinated omission).
+ *  Returns false if the phase ended while we were waiting.
+ */
+inline bool
+timed_test(uintptr_t id, uint32_t* seed, LatencyHistogram* hist,
+           arrivals_t* arr)
+{
+    if (!hist && !arr) {
+        bench_test(id, seed);
+        return true;
+    }
+    if (arr) {
+        while ((getElapsedTime() < arr->due()) && CFG.running)
+            spin64();
+        if (!CFG.running)
+            return false;
+    }
+    uint64_t start = arr ? arr->due() : getElapsedTime();
+    bench_test(id, seed);
+    if (hist)
+        hist->record(getElapsedTime() - start);
+    if (arr)
+        arr->advance();
+    return true;
 }
 
-/*** Run a timed or fixed-count experiment */
+/**
+ *  Run one phase of the experiment: for 'secs' seconds or, if 'execute' is
+ *  nonzero, for that many transactions per thread.  Only measured phases
+ *  record latencies and contribute to the reported results.
+ */
 void
-run(uintptr_t id)
+run_phase(uintptr_t id, uint32_t* seed, uint32_t secs, uint32_t execute,
+          bool measured)
 {
-    // create a transactional context (repeat calls from thread 0 are OK)
-    TM_THREAD_INIT();
+    LatencyHistogram* hist = (measured && CFG.latency) ? histograms[id] : NULL;
 
-    // wait until all threads created, then set alarm and read timer
-    barrier(0);
+    // wait until all threads are ready, then set alarm and read timer
+    barrier();
     if (id == 0) {
-        if (!CFG.execute) {
+        CFG.running = true;
+        if (!execute) {
             signal(SIGALRM, catch_SIGALRM);
-            alarm(CFG.duration);
+            alarm(secs);
         }
-        CFG.time = getElapsedTime();
+        phase_start = getElapsedTime();
+#if defined(STM_PERF) && !defined(STM_API_CXXTM)
+        if (measured)
+            stm::get_perf_counters(&perf_start);
+#endif
     }
 
-    // wait until read of start timer finishes, then start transactios
-    barrier(1);
+    // take our slot in the deterministic order (PipelineDet) while no
+    // transactions are running
+    if (det_order)
+        TM_DET_JOIN(id, CFG.threads);
+
+    // wait until read of start timer finishes, then start transactions
+    barrier();
+
+    // open-loop warmups run at the offered load too, but are not timed
+    arrivals_t schedule(id, phase_start);
+    arrivals_t* arr = CFG.rate ? &schedule : NULL;
 
     uint32_t count = 0;
-    uint32_t seed = id; // not everyone needs a seed, but we have to support it
-    if (!CFG.execute) {
+    if (!execute) {
         // run txns until alarm fires
         while (CFG.running) {
-            bench_test(id, &seed);
+            if (!timed_test(id, seed, hist, arr))
+                break;
             ++count;
             nontxnwork(); // some nontx work between txns?
         }
     }
     else {
         // run fixed number of txns
-        for (uint32_t e = 0; e < CFG.execute; e++) {
-            bench_test(id, &seed);
+        for (uint32_t e = 0; e < execute; e++) {
+            timed_test(id, seed, hist, arr);
             ++count;
             nontxnwork(); // some nontx work between txns?
         }
     }
+    uint64_t end = getElapsedTime();
+    if (det_order)
+        TM_DET_LEAVE();
 
     // wait until all txns finish, then get time
-    barrier(2);
-    if (id == 0)
-        CFG.time = getElapsedTime() - CFG.time;
+    barrier();
+    if (id == 0) {
+        phase_time = getElapsedTime() - phase_start;
+#if defined(STM_PERF) && !defined(STM_API_CXXTM)
+        if (measured)
+            perf_accumulate();
+#endif
+    }
 
     // add this thread's count to an accumulator
-    faa32(&CFG.txcount, count);
+    faa32(&phase_txns, count);
+    if (arr)
+        faa32(&phase_backlog, arr->overdue(end));
+
+    // once everyone has reported, thread 0 records the phase
+    barrier();
+    if (id == 0) {
+        if (measured) {
+            trial_tput.push_back((1000000000.0 * phase_txns) / phase_time);
+            CFG.txcount += phase_txns;
+            CFG.time += phase_time;
+            backlog += phase_backlog;
+        }
+        phase_txns = 0;
+        phase_backlog = 0;
+    }
+}
+
+/*** Run a timed or fixed-count experiment, with optional warmup */
+void
+experiment(uintptr_t id, uint32_t* seed)
+{
+    // warmup is always timed, even for fixed-count experiments
+    if (CFG.warmup)
+        run_phase(id, seed, CFG.warmup, 0, false);
+
+    for (uint32_t t = 0; t < CFG.trials; ++t)
+        run_phase(id, seed, CFG.duration, CFG.execute, true);
+}
+
+/**
+ *  Run one experiment per (algorithm, thread count, offered load) cell, on
+ *  the data structure that bench_init built once.  Thread 0 switches
+ *  algorithms while everyone else waits outside of transactions, and
+ *  verifies the benchmark invariants after each cell.
+ */
+void
+sweep(uintptr_t id, uint32_t* seed)
+{
+    for (size_t a = 0; a < sweep_algs.size(); ++a) {
+        for (size_t c = 0; c < sweep_threads.size() * sweep_rates.size();
+             ++c) {
+            size_t t = c / sweep_rates.size();
+            sweep_barrier.wait(workers);
+            if (id == 0) {
+                // set the algorithm for every cell, since bench_verify may
+                // have used TM_BEGIN_FAST_INITIALIZATION, which restores the
+                // startup configuration
+                TM_SET_POLICY(sweep_algs[a].c_str());
+                det_order = (sweep_algs[a] == "PipelineDet");
+                CFG.threads = sweep_threads[t];
+                CFG.rate = sweep_rates[c % sweep_rates.size()];
+                reset_results();
+            }
+            sweep_barrier.wait(workers);
+
+            if (id < CFG.threads)
+                experiment(id, seed);
+
+            sweep_barrier.wait(workers);
+            if (id == 0) {
+                const char* alg = sweep_algs[a].c_str();
+                cell_t cell;
+                cell.alg = alg;
+                cell.threads = CFG.threads;
+                cell.rate = CFG.rate;
+                cell.throughput = trial_stats_t().mean;
+                cell.p99 = CFG.latency ? merged_latency()->percentile(99) : 0;
+                cell.verified = bench_verify();
+                cells.push_back(cell);
+                std::cout << "Verification: "
+                          << (cell.verified ? "Passed" : "Failed") << "\n";
+                dump_csv(alg);
+                dump_json(alg);
+            }
+        }
+    }
+}
+
+/*** Run this thread's part of the experiment, or of the sweep */
+void
+run(uintptr_t id)
+{
+    // pin first, so that per-thread metadata is allocated on our node
+    placement.pin(id);
+
+    // create a transactional context (repeat calls from thread 0 are OK)
+    TM_THREAD_INIT();
+
+    if (CFG.latency)
+        histograms[id] = new LatencyHistogram();
+
+    uint32_t seed = id; // not everyone needs a seed, but we have to support it
+
+    if (sweep_algs.empty())
+        experiment(id, &seed);
+    else
+        sweep(id, &seed);
 }
 
 /**
@@ -212,9 +780,36 @@ run_wrapper(void* i)
 int main(int argc, char** argv) {
     parseargs(argc, argv);
     bench_reparse();
+    if (!placement.configure(affinity_policy, numa_policy))
+        exit(1);
+    if (!KEYS.configure(CFG.keydist, CFG.elements))
+        exit(1);
+
+    // thread 0 builds the benchmark data structures, so pin it before it
+    // first-touches them
+    placement.pin(0);
     TM_SYS_INIT();
     TM_THREAD_INIT();
+    placement.begin_first_touch();
     bench_init();
+    placement.end_first_touch();
+
+    // a sweep over either list defaults the other one to the plain
+    // configuration, and needs enough threads for its largest cell
+    bool sweeping = !sweep_algs.empty() || !sweep_threads.empty() ||
+                    (sweep_rates.size() > 1);
+    if (sweeping) {
+        if (sweep_algs.empty())
+            sweep_algs.push_back(TM_GET_ALGNAME());
+        if (sweep_threads.empty())
+            sweep_threads.push_back(CFG.threads);
+        CFG.threads = 0;
+        for (size_t i = 0; i < sweep_threads.size(); ++i)
+            if (sweep_threads[i] > CFG.threads)
+                CFG.threads = sweep_threads[i];
+    }
+    workers = CFG.threads;
+    det_order = !strcmp(TM_GET_ALGNAME(), "PipelineDet");
 
     void* args[256];
     pthread_t tid[256];
@@ -223,11 +818,11 @@ int main(int argc, char** argv) {
     pthread_attr_t attr;
     pthread_attr_init(&attr);
     pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
-    for (uintptr_t i = 0; i < CFG.threads; i++)
+    for (uintptr_t i = 0; i < workers; i++)
         args[i] = reinterpret_cast<void*>(i);
 
     // actually create the threads
-    for (uint32_t j = 1; j < CFG.threads; j++)
+    for (uint32_t j = 1; j < workers; j++)
         pthread_create(&tid[j], &attr, &run_wrapper, args[j]);
 
     // all of the other threads should be queued up, waiting to run the
@@ -240,13 +835,19 @@ int main(int argc, char** argv) {
 
     // everyone should be done.  Join all threads so we don't leave anything
     // hanging around
-    for (uint32_t k = 1; k < CFG.threads; k++)
+    for (uint32_t k = 1; k < workers; k++)
         pthread_join(tid[k], NULL);
 
-    bool v = bench_verify();
-    std::cout << "Verification: " << (v ? "Passed" : "Failed") << "\n";
+    if (sweeping) {
+        dump_matrix();
+    }
+    else {
+        bool v = bench_verify();
+        std::cout << "Verification: " << (v ? "Passed" : "Failed") << "\n";
 
-    dump_csv();
+        dump_csv(TM_GET_ALGNAME());
+        dump_json(TM_GET_ALGNAME());
+    }
 
     // And call sys shutdown stuff
     TM_SYS_SHUTDOWN();
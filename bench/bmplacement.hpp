@@ -0,0 +1,291 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#ifndef BMPLACEMENT_HPP__
+#define BMPLACEMENT_HPP__
+
+#include <stm/config.h>
+#include <stdint.h>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(STM_OS_LINUX)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ *  Thread and memory placement for the benchmark harness.
+ *
+ *  An affinity policy maps benchmark thread ids to CPUs:
+ *
+ *    compact  - fill each NUMA node's CPUs before moving to the next
+ *    scatter  - deal threads round-robin across the NUMA nodes
+ *    <list>   - an explicit CPU list, such as "0,2,4-7"
+ *
+ *  Only CPUs in the process's initial affinity mask are used by compact and
+ *  scatter, and threads wrap around when there are more threads than CPUs.
+ *
+ *  A NUMA policy controls where the pages touched during bench_init land:
+ *
+ *    local      - on the node of the initializing thread (the OS default)
+ *    interleave - round-robin across all nodes
+ *    <k>        - on node k, which must be online
+ *
+ *  We set the memory policy with the set_mempolicy system call, which is what
+ *  libnuma and mbind sit on, so there is no new link dependency (and nothing
+ *  to break in 32-bit multilib builds).  Everything is a no-op, with a
+ *  warning, on platforms other than Linux.
+ */
+class Placement
+{
+    std::string       affinity;         // policy name, "" for none
+    std::string       numa;             // policy name, "" for none
+    std::vector<int>  cpus;             // thread id -> cpu, mod size()
+    std::vector<std::vector<int> > nodes; // cpus of each NUMA node
+    std::vector<int>  node_ids;         // the id of each entry in nodes
+
+    /**
+     *  parse a cpu list like "0-3,8,10-11"; false on a malformed list, or
+     *  one with an entry that is negative or not below 'limit'
+     */
+    static bool parse_list(const std::string& s, std::vector<int>& out,
+                           long limit = INT_MAX)
+    {
+        if (s.empty() || s[s.size() - 1] == ',')
+            return false;
+        std::istringstream list(s);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            char* end;
+            long lo = strtol(item.c_str(), &end, 10);
+            long hi = lo;
+            if (end == item.c_str())
+                return false;
+            if (*end == '-') {
+                const char* start = end + 1;
+                hi = strtol(start, &end, 10);
+                if (end == start)
+                    return false;
+            }
+            if (*end != '\0' && *end != '\n')
+                return false;
+            if (lo < 0 || hi >= limit || lo > hi)
+                return false;
+            for (long c = lo; c <= hi; ++c)
+                out.push_back(c);
+        }
+        return !out.empty();
+    }
+
+    /*** find the cpus of each NUMA node that we are allowed to run on */
+    void discover()
+    {
+#if defined(STM_OS_LINUX)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        sched_getaffinity(0, sizeof(mask), &mask);
+        // node ids need not be consecutive, so get them from the online list
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string ids;
+        std::vector<int> online_ids;
+        if (online && std::getline(online, ids))
+            parse_list(ids, online_ids);
+        for (size_t k = 0; k < online_ids.size(); ++k) {
+            std::ostringstream path;
+            path << "/sys/devices/system/node/node" << online_ids[k]
+                 << "/cpulist";
+            std::ifstream f(path.str().c_str());
+            if (!f)
+                continue;
+            std::string line;
+            std::vector<int> all, mine;
+            std::getline(f, line);
+            parse_list(line, all);
+            for (size_t i = 0; i < all.size(); ++i)
+                if (all[i] < CPU_SETSIZE && CPU_ISSET(all[i], &mask))
+                    mine.push_back(all[i]);
+            nodes.push_back(mine);
+            node_ids.push_back(online_ids[k]);
+        }
+        // no NUMA information: treat the machine as a single node
+        if (nodes.empty()) {
+            nodes.push_back(std::vector<int>());
+            node_ids.push_back(0);
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &mask))
+                    nodes[0].push_back(c);
+        }
+#endif
+    }
+
+#if defined(STM_OS_LINUX)
+    /*** the set_mempolicy modes that we use, from <numaif.h> */
+    enum { MPOL_DEFAULT_ = 0, MPOL_BIND_ = 2, MPOL_INTERLEAVE_ = 3 };
+
+    static bool set_mempolicy(int mode, const unsigned long* mask,
+                              unsigned long maxnode)
+    {
+        return syscall(SYS_set_mempolicy, mode, mask, maxnode) == 0;
+    }
+#endif
+
+  public:
+    Placement() : affinity(""), numa(""), cpus(), nodes(), node_ids() { }
+
+    /**
+     *  Record the requested policies, and work out the cpu of each thread.
+     *  Returns false, after printing why, if a policy is not valid.
+     */
+    bool configure(const std::string& aff, const std::string& mem)
+    {
+        affinity = aff;
+        numa = mem;
+        if (affinity == "" && numa == "")
+            return true;
+
+#if defined(STM_OS_LINUX)
+        discover();
+        if (affinity == "compact") {
+            for (size_t n = 0; n < nodes.size(); ++n)
+                cpus.insert(cpus.end(), nodes[n].begin(), nodes[n].end());
+        }
+        else if (affinity == "scatter") {
+            for (size_t i = 0; ; ++i) {
+                bool added = false;
+                for (size_t n = 0; n < nodes.size(); ++n) {
+                    if (i < nodes[n].size()) {
+                        cpus.push_back(nodes[n][i]);
+                        added = true;
+                    }
+                }
+                if (!added)
+                    break;
+            }
+        }
+        else if (affinity != "" &&
+                 !parse_list(affinity, cpus, CPU_SETSIZE))
+        {
+            std::cerr << "Invalid affinity policy: " << affinity << "\n";
+            return false;
+        }
+
+        if (numa != "" && numa != "local" && numa != "interleave") {
+            char* end;
+            unsigned long n = strtoul(numa.c_str(), &end, 10);
+            bool known = false;
+            for (size_t k = 0; k < node_ids.size(); ++k)
+                known |= (node_ids[k] == (int)n);
+            if (*end != '\0' || !known || n >= 8 * sizeof(unsigned long)) {
+                std::cerr << "Invalid NUMA policy: " << numa << "\n";
+                return false;
+            }
+        }
+#else
+        std::cerr << "Warning: thread and memory placement are not "
+                  << "supported on this platform\n";
+#endif
+        return true;
+    }
+
+    /*** pin the calling thread to the cpu for thread id, if we have one */
+    void pin(uintptr_t id) const
+    {
+#if defined(STM_OS_LINUX)
+        if (cpus.empty())
+            return;
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpus[id % cpus.size()], &mask);
+        if (sched_setaffinity(0, sizeof(mask), &mask))
+            std::cerr << "Warning: could not pin thread " << id
+                      << " to cpu " << cpus[id % cpus.size()] << "\n";
+#endif
+    }
+
+    /*** apply the NUMA policy to the pages touched from now on */
+    void begin_first_touch() const
+    {
+#if defined(STM_OS_LINUX)
+        if (numa == "" || numa == "local")
+            return;
+        unsigned long mask = 0;
+        bool ok;
+        if (numa == "interleave") {
+            for (size_t k = 0; k < node_ids.size(); ++k)
+                if (node_ids[k] < (int)(8 * sizeof(mask)))
+                    mask |= 1UL << node_ids[k];
+            ok = set_mempolicy(MPOL_INTERLEAVE_, &mask, 8 * sizeof(mask));
+        }
+        else {
+            mask = 1UL << strtoul(numa.c_str(), NULL, 10);
+            ok = set_mempolicy(MPOL_BIND_, &mask, 8 * sizeof(mask));
+        }
+        if (!ok)
+            std::cerr << "Warning: could not set NUMA policy " << numa << "\n";
+#endif
+    }
+
+    /*** return to allocating on the local node */
+    void end_first_touch() const
+    {
+#if defined(STM_OS_LINUX)
+        if (numa == "" || numa == "local")
+            return;
+        set_mempolicy(MPOL_DEFAULT_, NULL, 0);
+#endif
+    }
+
+    /*** true if any placement was requested */
+    bool active() const { return affinity != "" || numa != ""; }
+
+    /*** describe the placement of 'threads' threads, for the csv */
+    std::string csv(uintptr_t threads) const
+    {
+        std::ostringstream out;
+        out << ", a=" << (affinity == "" ? "none" : affinity.c_str())
+            << ", n=" << (numa == "" ? "local" : numa.c_str())
+            << ", nodes=" << nodes.size() << ", cpus=";
+        if (cpus.empty())
+            out << "any";
+        for (uintptr_t i = 0; i < threads && !cpus.empty(); ++i)
+            out << (i ? "/" : "") << cpus[i % cpus.size()];
+        return out.str();
+    }
+
+    /*** describe the placement of 'threads' threads, as a JSON object */
+    std::string json(uintptr_t threads) const
+    {
+        std::ostringstream out;
+        out << "{\"affinity\": \""
+            << (affinity == "" ? "none" : affinity.c_str()) << "\""
+            << ", \"numa\": \"" << (numa == "" ? "local" : numa.c_str())
+            << "\", \"nodes\": " << nodes.size() << ", \"cpus\": ";
+        if (cpus.empty()) {
+            out << "null";
+        }
+        else {
+            out << "[";
+            for (uintptr_t i = 0; i < threads; ++i)
+                out << (i ? ", " : "") << cpus[i % cpus.size()];
+            out << "]";
+        }
+        out << "}";
+        return out.str();
+    }
+};
+
+#endif // BMPLACEMENT_HPP__
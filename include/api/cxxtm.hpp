@@ -31,7 +31,15 @@ extern "C" {
 
 #define TM_CALLABLE         [[transaction_safe]]
 
-#define TM_BEGIN(TYPE)      __transaction [[TYPE]] {
+/**
+ *  The compiler has no read-only transactions, so TM_BEGIN(readonly) is just
+ *  an atomic transaction here
+ */
+#define TM_CXXTM_atomic     atomic
+#define TM_CXXTM_relaxed    relaxed
+#define TM_CXXTM_readonly   atomic
+
+#define TM_BEGIN(TYPE)      __transaction [[TM_CXXTM_##TYPE]] {
 #define TM_END              }
 
 #define TM_WAIVER           __transaction [[waiver]]
@@ -75,6 +83,8 @@ namespace stm
 #endif
 #define  TM_BEGIN_FAST_INITIALIZATION  nop
 #define  TM_END_FAST_INITIALIZATION    nop
+#define  TM_DET_JOIN(L, N)
+#define  TM_DET_LEAVE()
 #else
 #error "We're not prepared for your implementation of the C++ TM spec."
 #endif
@@ -22,15 +22,27 @@
  *  TM_BECOME_IRREVOC() : Become irrevocable or abort
  *  TM_READ(var)        : Read from shared memory from a txn
  *  TM_WRITE(var, val)  : Write to shared memory from a txn
- *  TM_BEGIN(type)      : Start a transaction... use 'atomic' as type
+ *  TM_BEGIN(type)      : Start a transaction... use 'atomic' as type, or
+ *                        'readonly' for transactions that never write
  *  TM_END              : End a transaction
  *
  *  Custom Features:
  *
  *  stm::restart()                : Self-abort and immediately retry a txn
+ *  stm::is_irrevoc(*tx)          : True if the txn can no longer abort
+ *  stm::on_commit(fn, arg)       : Run fn(arg) after the txn commits
+ *  stm::on_abort(fn, arg)        : Run fn(arg) after the txn aborts
+ *  stm::det_join(lane, lanes)    : Commit in a deterministic order (PipelineDet)
+ *  stm::det_leave()              : Stop holding up the deterministic order
  *  TM_BEGIN_FAST_INITIALIZATION  : For fast initialization
  *  TM_END_FAST_INITIALIZATION    : For fast initialization
  *  TM_GET_ALGNAME()              : Get the current algorithm name
+ *  stm::tvar<T>                  : A word-sized variable with its own orec
+ *  TM_READ_TVAR(var)             : Read a tvar<T> from a txn
+ *  TM_WRITE_TVAR(var, val)       : Write a tvar<T> from a txn
+ *  TM_MEMCPY(dst, src, len)      : Copy shared memory from a txn
+ *  TM_MEMSET(dst, c, len)        : Fill shared memory from a txn
+ *  TM_MEMCMP(a, b, len)          : Compare shared memory from a txn
  *
  *  Compiler Compatibility::Transaction Descriptor Management:
  *
@@ -53,6 +65,9 @@
 #include <stm/config.h>
 #include <common/platform.hpp>
 #include <stm/txthread.hpp>
+#include <stm/trace.hpp>
+#include <stm/perf.hpp>
+#include <stm/stats.hpp>
 
 namespace stm
 {
@@ -67,8 +82,26 @@ namespace stm
    *    (a) avoid overhead under subsumption nesting and
    *    (b) avoid code duplication or MACRO nastiness
    */
+  /**
+   *  The kinds of transaction that TM_BEGIN accepts.  The names are pasted
+   *  from TM_BEGIN's argument, hence the odd capitalization.
+   */
+  enum tx_kind_t { TX_atomic, TX_relaxed, TX_readonly };
+
+  /**
+   *  Barriers for transactions that were declared read-only, under
+   *  algorithms with read-only barriers (LLT, TML and the OrecEager family).
+   *  There, writing in such a transaction is a fatal error.  Other
+   *  algorithms run it as they would any transaction.
+   */
+  TM_FASTCALL void commit_readonly(TxThread* tx);
+  TM_FASTCALL void write_readonly(STM_WRITE_SIG(,,,));
+  TM_FASTCALL void write_obj_readonly(STM_WRITE_OBJ_SIG(,,,));
+  void write_block_readonly(STM_WRITE_BLOCK_SIG(,,,));
+
   TM_INLINE
-  inline void begin(TxThread* tx, scope_t* s, uint32_t /*abort_flags*/)
+  inline void begin(TxThread* tx, scope_t* s, uint32_t /*abort_flags*/,
+                    tx_kind_t kind = TX_atomic)
   {
       if (++tx->nesting_depth > 1)
           return;
@@ -92,9 +125,27 @@ namespace stm
           tx->total_nontxn_time += (tick() - tx->end_txn_time);
 
       // now call the per-algorithm begin function
-      TxThread::tmbegin(tx);
+      STM_PERF_PHASE(tx, PERF_BEGIN);
+      bool irrevocable = TxThread::tmbegin(tx);
+      STM_TRACE_EVENT(tx, (kind == TX_readonly) ? TRACE_BEGIN_RO : TRACE_BEGIN,
+                      NULL, 0);
+
+      // a declared read-only transaction gets the current algorithm's
+      // read-only barriers, if it has any.  This is safe only after tmbegin,
+      // since that is what prevents the algorithm from changing.
+      if ((kind == TX_readonly) && !irrevocable && TxThread::tmread_ronly) {
+          tx->tmread   = TxThread::tmread_ronly;
+          tx->tmwrite  = write_readonly;
+          tx->tmcommit = commit_readonly;
+          tx->tmwrite_obj   = write_obj_readonly;
+          tx->tmwrite_block = write_block_readonly;
+      }
+      STM_PERF_PHASE(tx, PERF_BODY);
   }
 
+  /*** run (and discard) the work deferred by on_commit/on_abort */
+  void run_commit_handlers(TxThread* tx);
+
   /**
    *  Code to commit a transaction.  As in begin(), we are using forced
    *  inlining to save a little bit of overhead for subsumption nesting, and to
@@ -108,13 +159,20 @@ namespace stm
           return;
 
       // dispatch to the appropriate end function
+      STM_PERF_PHASE(tx, PERF_COMMIT);
       tx->tmcommit(tx);
+      STM_TRACE_EVENT(tx, TRACE_COMMIT, NULL, 0);
 
       // zero scope (to indicate "not in tx")
       CFENCE;
       tx->scope = NULL;
 
+      // run any deferred work
+      if (tx->commit_handlers.size() || tx->abort_handlers.size())
+          run_commit_handlers(tx);
+
       // record start of nontransactional time
+      STM_PERF_PHASE(tx, PERF_NONTX);
       tx->end_txn_time = tick();
   }
 
@@ -202,6 +260,12 @@ namespace stm
   /***  Report the algorithm name that was used to initialize libstm */
   const char* get_algname();
 
+  /**
+   *  Take a snapshot of the library's counters without stopping any thread
+   *  (see stm/stats.hpp)
+   */
+  void get_stats(stats_t* s);
+
   /**
    *  Become irrevocable.  Call this from within a transaction.
    */
@@ -211,6 +275,43 @@ namespace stm
    *  Abort the current transaction and restart immediately.
    */
   void restart();
+
+  /**
+   *  True if a transaction can no longer abort, because it became
+   *  irrevocable or because the algorithm never aborts (e.g., CGL).  Do not
+   *  call restart() in such a transaction.
+   */
+  bool is_irrevoc(const TxThread& tx);
+
+  /**
+   *  Defer fn(arg) until the current transaction commits, or run it once for
+   *  each aborted attempt of the current transaction.  Handlers run in
+   *  registration order, outside of any transaction, after writeback (or
+   *  undo) and allocator cleanup, so they are the place for I/O, logging,
+   *  and wakeups.  Handlers must not start transactions themselves.
+   */
+  void on_commit(void (*fn)(void*), void* arg);
+  void on_abort(void (*fn)(void*), void* arg);
+
+  /**
+   *  Deterministic order for PipelineDet.  Each thread that runs
+   *  transactions joins a distinct lane in [0, lanes), and PipelineDet
+   *  commits the lanes' transactions round-robin, so the same per-thread
+   *  transactions give the same final state on every run.  A lane that is
+   *  between transactions holds up the others, so leave before blocking or
+   *  when done.  Join and leave outside of transactions.
+   */
+  void det_join(uint32_t lane, uint32_t lanes);
+  void det_leave();
+
+  /**
+   *  Transactional bulk memory operations.  Both ranges are treated as
+   *  shared memory, and need not be aligned.  Each algorithm may provide
+   *  batched barriers for the word-aligned portion of the ranges.
+   */
+  void tx_memcpy(void* dst, const void* src, size_t len, TxThread* thread);
+  void tx_memset(void* dst, int c, size_t len, TxThread* thread);
+  int  tx_memcmp(const void* a, const void* b, size_t len, TxThread* thread);
 }
 
 /*** pull in the per-memory-access instrumentation framework */
@@ -225,14 +326,91 @@ namespace stm
   template <typename T>
   inline T stm_read(T* addr, TxThread* thread)
   {
-      return DISPATCH<T, sizeof(T)>::read(addr, thread);
+      STM_TRACE_ACCESS(thread, TRACE_READ, addr, sizeof(T));
+      STM_PERF_ENTER(thread, PERF_READ);
+      T val = DISPATCH<T, sizeof(T)>::read(addr, thread);
+      STM_PERF_LEAVE(thread);
+      return val;
   }
 
   template <typename T>
   inline void stm_write(T* addr, T val, TxThread* thread)
   {
+      STM_TRACE_ACCESS(thread, TRACE_WRITE, addr, sizeof(T));
+      STM_PERF_ENTER(thread, PERF_WRITE);
       DISPATCH<T, sizeof(T)>::write(addr, val, thread);
+      STM_PERF_LEAVE(thread);
   }
+
+  /**
+   *  A tvar<T> is a word-sized transactional variable that carries its own
+   *  orec on the same cache line as its data, instead of hashing into the
+   *  global orec table.  Orec-based STMs (the OrecEager family) use the
+   *  embedded orec directly, which saves the table lookup and the extra
+   *  cache miss, and avoids false conflicts with unrelated locations.  All
+   *  other STMs treat the tvar's data word as an ordinary location.
+   *
+   *  A transaction may freely mix tvar and address-based (TM_READ/TM_WRITE)
+   *  accesses, but any given tvar must only be accessed through its
+   *  get()/set() methods (or TM_READ_TVAR/TM_WRITE_TVAR) while transactions
+   *  are running, since its embedded orec and the global orec of its data
+   *  word do not know about each other.
+   *
+   *  NB: T must be no larger than a word.  The tvar owns the whole word, so
+   *      sub-word types do not need byte-granularity logging.
+   *
+   *  NB: the cache line alignment only holds for statically allocated tvars
+   *      and for heap memory with sufficient alignment; correctness does not
+   *      depend on it.
+   */
+  template <typename T>
+  class tvar
+  {
+      /*** fails to compile if T does not fit in a word */
+      typedef char word_sized_check[(sizeof(T) <= sizeof(void*)) ? 1 : -1];
+
+      /*** for converting between T and the word that the barriers speak */
+      union word_t
+      {
+          T     val;
+          void* word;
+      };
+
+      orec_t meta TM_ALIGN(CACHELINE_BYTES); // embedded version/lock word
+      word_t data;                           // the variable itself
+
+    public:
+      tvar()              { meta.v.all = 0; meta.p = 0; data.word = NULL; }
+      explicit tvar(T v)  { meta.v.all = 0; meta.p = 0; data.word = NULL;
+                            data.val = v; }
+
+      /*** transactional read */
+      T get(TxThread* tx)
+      {
+          word_t tmp;
+          STM_TRACE_ACCESS(tx, TRACE_READ, &data.word, sizeof(void*));
+          STM_PERF_ENTER(tx, PERF_READ);
+          tmp.word = tx->tmread_obj(tx, &meta, &data.word);
+          STM_PERF_LEAVE(tx);
+          return tmp.val;
+      }
+
+      /*** transactional write */
+      void set(T v, TxThread* tx)
+      {
+          word_t tmp;
+          tmp.word = NULL;
+          tmp.val = v;
+          STM_TRACE_ACCESS(tx, TRACE_WRITE, &data.word, sizeof(void*));
+          STM_PERF_ENTER(tx, PERF_WRITE);
+          tx->tmwrite_obj(tx, &meta, &data.word, tmp.word);
+          STM_PERF_LEAVE(tx);
+      }
+
+      /*** nontransactional accessors, e.g., for initialization */
+      T    unsafe_get() const { return data.val; }
+      void unsafe_set(T v)    { data.val = v; }
+  };
 } // namespace stm
 
 /**
@@ -240,6 +418,11 @@ namespace stm
  */
 #define TM_READ(var)       stm::stm_read(&var, tx)
 #define TM_WRITE(var, val) stm::stm_write(&var, val, tx)
+#define TM_READ_TVAR(var)       (var).get(tx)
+#define TM_WRITE_TVAR(var, val) (var).set(val, tx)
+#define TM_MEMCPY(dst, src, len) stm::tx_memcpy(dst, src, len, tx)
+#define TM_MEMSET(dst, c, len)   stm::tx_memset(dst, c, len, tx)
+#define TM_MEMCMP(a, b, len)     stm::tx_memcmp(a, b, len, tx)
 
 /**
  *  This is the way to start a transaction
@@ -249,7 +432,7 @@ namespace stm
     stm::TxThread* tx = (stm::TxThread*)stm::Self;          \
     jmp_buf _jmpbuf;                                        \
     uint32_t abort_flags = setjmp(_jmpbuf);                 \
-    stm::begin(tx, &_jmpbuf, abort_flags);                  \
+    stm::begin(tx, &_jmpbuf, abort_flags, stm::TX_##TYPE); \
     CFENCE;                                                 \
     {
 
@@ -281,8 +464,10 @@ namespace stm
 #define TM_ALLOC             stm::tx_alloc
 #define TM_FREE              stm::tx_free
 #define TM_SET_POLICY(P)     stm::set_policy(P)
-#define TM_BECOME_IRREVOC()  stm::becom_irrevoc()
+#define TM_BECOME_IRREVOC()  stm::become_irrevoc()
 #define TM_GET_ALGNAME()     stm::get_algname()
+#define TM_DET_JOIN(L, N)    stm::det_join(L, N)
+#define TM_DET_LEAVE()       stm::det_leave()
 
 /**
  * This is gross.  ITM, like any good compiler, will make nontransactional
@@ -151,4 +151,160 @@ inline void mcs_release(mcs_qnode_t** lock, mcs_qnode_t* mine)
     mine->next->flag = false;
 }
 
+/**
+ *  Cohort locks (Dice, Marathe and Shavit, PPoPP 2012): a global lock, plus
+ *  a local lock per NUMA node.  A thread takes its node's local lock, and
+ *  then the global lock unless the previous local owner passed it along.
+ *  On release, if another thread on the same node is waiting, the global
+ *  lock is passed to it with the local lock, so the lock (and the data it
+ *  protects) stays on one node.  After COHORT_PASS_LIMIT consecutive passes
+ *  the global lock is released anyway, so other nodes are not starved.
+ *
+ *  Nodes beyond COHORT_MAX_NODES share local locks, which costs locality
+ *  but not correctness.
+ */
+#define COHORT_MAX_NODES  16
+#define COHORT_PASS_LIMIT 64
+
+/***  C-TKT-TKT: ticket locks per node and globally */
+struct cohort_ticket_lock_t
+{
+    ticket_lock_t global;
+    struct node_t
+    {
+        ticket_lock_t      local;
+        volatile uintptr_t has_global;  // set when the lock is passed along
+        uintptr_t          passes;      // consecutive local handoffs
+        char               pad[64 - 4 * sizeof(uintptr_t)];
+    } nodes[COHORT_MAX_NODES];
+};
+
+/***  C-TKT-TKT acquire.  Returns how long we spun, as ticket_acquire */
+inline int cohort_ticket_acquire(cohort_ticket_lock_t* lock, uint32_t node)
+{
+    cohort_ticket_lock_t::node_t* n = &lock->nodes[node % COHORT_MAX_NODES];
+    int ret = ticket_acquire(&n->local);
+    if (!n->has_global)
+        ret += ticket_acquire(&lock->global);
+    return ret;
+}
+
+/**
+ *  C-TKT-TKT release.  We hold the local ticket now_serving, so anyone
+ *  holding a later ticket is a waiter on our node.
+ */
+inline void cohort_ticket_release(cohort_ticket_lock_t* lock, uint32_t node)
+{
+    cohort_ticket_lock_t::node_t* n = &lock->nodes[node % COHORT_MAX_NODES];
+    if ((n->local.next_ticket - n->local.now_serving > 1) &&
+        (++n->passes < COHORT_PASS_LIMIT))
+    {
+        n->has_global = 1;
+    }
+    else {
+        n->passes = 0;
+        n->has_global = 0;
+        ticket_release(&lock->global);
+    }
+    CFENCE;
+    ticket_release(&n->local);
+}
+
+/***  C-BO-MCS: MCS locks per node, and a global TATAS lock with backoff */
+struct cohort_mcs_lock_t
+{
+    tatas_lock_t global;
+    struct node_t
+    {
+        mcs_qnode_t*       tail;
+        volatile uintptr_t has_global;  // set when the lock is passed along
+        uintptr_t          passes;      // consecutive local handoffs
+        char               pad[64 - 3 * sizeof(uintptr_t)];
+    } nodes[COHORT_MAX_NODES];
+};
+
+/***  C-BO-MCS acquire.  Returns how long we spun */
+inline int cohort_mcs_acquire(cohort_mcs_lock_t* lock, uint32_t node,
+                              mcs_qnode_t* mine)
+{
+    cohort_mcs_lock_t::node_t* n = &lock->nodes[node % COHORT_MAX_NODES];
+    int ret = mcs_acquire(&n->tail, mine);
+    if (!n->has_global)
+        ret += tatas_acquire(&lock->global);
+    return ret;
+}
+
+/**
+ *  C-BO-MCS release.  A successor in our MCS queue is a waiter on our node.
+ *  If it has not linked itself in yet, we do not wait for it: we release
+ *  the global lock, and it will acquire the global lock itself.
+ */
+inline void cohort_mcs_release(cohort_mcs_lock_t* lock, uint32_t node,
+                               mcs_qnode_t* mine)
+{
+    cohort_mcs_lock_t::node_t* n = &lock->nodes[node % COHORT_MAX_NODES];
+    if (mine->next && (++n->passes < COHORT_PASS_LIMIT)) {
+        n->has_global = 1;
+    }
+    else {
+        n->passes = 0;
+        n->has_global = 0;
+        tatas_release(&lock->global);
+    }
+    CFENCE;
+    mcs_release(&n->tail, mine);
+}
+
+/**
+ *  C-BO-BO: TATAS locks with backoff per node and globally.  A TATAS lock
+ *  has no queue, so threads that fail to get their node's lock count
+ *  themselves in 'waiting', which tells the releaser that there is a local
+ *  waiter to pass the global lock to.
+ */
+struct cohort_tatas_lock_t
+{
+    tatas_lock_t global;
+    struct node_t
+    {
+        tatas_lock_t       local;
+        volatile uintptr_t waiting;     // threads spinning on local
+        volatile uintptr_t has_global;  // set when the lock is passed along
+        uintptr_t          passes;      // consecutive local handoffs
+        char               pad[64 - 4 * sizeof(uintptr_t)];
+    } nodes[COHORT_MAX_NODES];
+};
+
+/***  C-BO-BO acquire.  Returns how long we spun, as tatas_acquire */
+inline int cohort_tatas_acquire(cohort_tatas_lock_t* lock, uint32_t node)
+{
+    cohort_tatas_lock_t::node_t* n = &lock->nodes[node % COHORT_MAX_NODES];
+    int ret = 0;
+    if (tas(&n->local)) {
+        faiptr(&n->waiting);
+        ret = tatas_acquire_slowpath(&n->local);
+        faaptr(&n->waiting, -1);
+    }
+    if (!n->has_global)
+        ret += tatas_acquire(&lock->global);
+    return ret;
+}
+
+/**
+ *  C-BO-BO release.  If a waiter counted itself after we looked, it will
+ *  find has_global clear and acquire the global lock itself.
+ */
+inline void cohort_tatas_release(cohort_tatas_lock_t* lock, uint32_t node)
+{
+    cohort_tatas_lock_t::node_t* n = &lock->nodes[node % COHORT_MAX_NODES];
+    if (n->waiting && (++n->passes < COHORT_PASS_LIMIT)) {
+        n->has_global = 1;
+    }
+    else {
+        n->passes = 0;
+        n->has_global = 0;
+        tatas_release(&lock->global);
+    }
+    tatas_release(&n->local);
+}
+
 #endif // LOCKS_HPP__
@@ -91,6 +91,39 @@ namespace stm
 #endif
       }
 
+      /**
+       *  bit set function for filters that many threads add to: atomic_add
+       *  assumes a single writer.  We skip the CAS when the bit is set.
+       */
+      ALWAYS_INLINE
+      void shared_add(const void* const val) volatile
+      {
+          const uint32_t index  = hash(val);
+          const uint32_t block  = index / WORD_SIZE;
+          const uint32_t offset = index % WORD_SIZE;
+          uintptr_t w = word_filter[block];
+          while (!(w & (1u << offset))) {
+              if (bcasptr(&word_filter[block], w, w | (1u << offset)))
+                  return;
+              w = word_filter[block];
+          }
+      }
+
+      /*** union, for filters that other threads shared_add to */
+      TM_INLINE
+      void shared_unionwith(const volatile BitFilter<BITS>* rhs) volatile
+      {
+          for (uint32_t i = 0; i < WORD_BLOCKS; ++i) {
+              uintptr_t bits = rhs->word_filter[i];
+              uintptr_t w = word_filter[i];
+              while ((w | bits) != w) {
+                  if (bcasptr(&word_filter[i], w, w | bits))
+                      break;
+                  w = word_filter[i];
+              }
+          }
+      }
+
       /*** simple lookup */
       ALWAYS_INLINE
       bool lookup(const void* const val) const volatile
@@ -69,6 +69,8 @@ namespace stm {
       bool isValid() const {
           return *addr == val;
       }
+
+      void** getAddr() const { return addr; }
   };
 
   /**
@@ -129,6 +131,8 @@ namespace stm {
       bool isValid() const {
           return ((uintptr_t)val & mask) == ((uintptr_t)*addr & mask);
       }
+
+      void** getAddr() const { return addr; }
   };
 
   /**
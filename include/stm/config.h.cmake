@@ -38,6 +38,15 @@
 // Histogram generation
 #cmakedefine STM_COUNTCONSEC_YES
 
+// Transaction tracing
+#cmakedefine STM_TRACE
+
+// Per-phase performance counters
+#cmakedefine STM_PERF
+
+// Periodic statistics export
+#cmakedefine STM_STATS_EXPORT
+
 // ProfileTMtrigger
 #cmakedefine STM_PROFILETMTRIGGER_ALL
 #cmakedefine STM_PROFILETMTRIGGER_PATHOLOGY
@@ -52,6 +61,9 @@
 #cmakedefine STM_WS_BYTELOG
 #cmakedefine STM_USE_WORD_LOGGING_VALUELIST
 
+// Configured orec stripe size, as log2 of the bytes covered by an orec
+#cmakedefine STM_OREC_SHIFT @STM_OREC_SHIFT@
+
 // Configured options
 #cmakedefine STM_PROTECT_STACK
 #cmakedefine STM_ABORT_ON_THROW
@@ -30,6 +30,12 @@ namespace stm
   void become_irrevoc();
   void restart();
   const char* get_algname();
+  void on_commit(void (*fn)(void*), void* arg);
+  void on_abort(void (*fn)(void*), void* arg);
+  void det_join(uint32_t lane, uint32_t lanes);
+  void det_leave();
+  void run_commit_handlers(TxThread*);
+  void run_abort_handlers(TxThread*);
 
   extern pad_word_t  threadcount;           // threads in system
   extern TxThread*   threads[MAX_THREADS];  // all TxThreads
@@ -73,6 +73,23 @@
 #   define STM_WRITE_SIG(tx, addr, val, mask) TxThread* tx, void** addr, void* val
 #endif
 
+/**
+ *  Barriers for tvar<T> objects receive the object's embedded orec along with
+ *  the address of its (word-sized, word-aligned) data.  The tvar owns the
+ *  whole word, so these barriers never need a mask.
+ */
+#define STM_READ_OBJ_SIG(tx, orec, addr)       TxThread* tx, orec_t* orec, void** addr
+#define STM_WRITE_OBJ_SIG(tx, orec, addr, val) TxThread* tx, orec_t* orec, void** addr, void* val
+
+/**
+ *  Block barriers move a run of whole, aligned words between shared memory
+ *  and a private buffer.  The transactional bulk memory operations handle
+ *  any unaligned prefix or suffix with the word barriers, so these never
+ *  need a mask either.
+ */
+#define STM_READ_BLOCK_SIG(tx, to, addr, words)    TxThread* tx, void** to, void** addr, size_t words
+#define STM_WRITE_BLOCK_SIG(tx, addr, from, words) TxThread* tx, void** addr, void* const* from, size_t words
+
 #if defined(STM_ABORT_ON_THROW)
 #   define STM_ROLLBACK_SIG(tx, exception, len)  \
     TxThread* tx, void** exception, size_t len
@@ -75,6 +75,29 @@ namespace stm
       volatile uintptr_t    p; // previous version number
   };
 
+  /**
+   *  A region summarizes a block of consecutive orecs, so that a reader can
+   *  validate many orecs with one check.  v is at least the version of any
+   *  orec in the block that a region-aware writer released, and writers
+   *  counts the region-aware writers that currently hold locks in the block.
+   */
+  struct region_t
+  {
+      volatile uintptr_t v;       // max version released into the region
+      volatile uintptr_t writers; // writers holding orecs in the region
+  };
+
+  /**
+   *  A read log entry for a region: the region's index, and a bit for each
+   *  of its orecs that the transaction read
+   */
+  struct region_read_t
+  {
+      uint32_t region;   // index of the region
+      uint64_t mask;     // orecs of the region that we read
+      region_read_t(uint32_t _r, uint64_t _m) : region(_r), mask(_m) { }
+  };
+
   /**
    *  Nano requires that we log not just the orec address, but also its value
    */
@@ -160,6 +183,16 @@ namespace stm
       rrec_t             readers;  // large bitmap for readers
   };
 
+  /**
+   *  Work deferred by on_commit/on_abort: a function and its argument
+   */
+  struct callback_t
+  {
+      void (*fn)(void*);
+      void* arg;
+      callback_t(void (*_fn)(void*), void* _arg) : fn(_fn), arg(_arg) { }
+  };
+
   /**
    *  In order to avoid a circular dependency, we need to declare some
    *  WriteSet support here.
@@ -183,7 +216,9 @@ namespace stm
   typedef MiniVector<bitlock_t*>   BitLockList;  // vector of bitlocks
   typedef BitFilter<1024>          filter_t;     // flat 1024-bit Bloom filter
   typedef MiniVector<nanorec_t>    NanorecList;  // <orec,val> pairs
+  typedef MiniVector<region_read_t> RegionReadList; // <region,mask> pairs
   typedef MiniVector<void*>        AddressList;  // for the mmpolicy
+  typedef MiniVector<callback_t>   CallbackList; // on_commit/on_abort work
 
   /**
    *  These are for counting consecutive aborts in a histogram.  We use them
@@ -196,13 +231,13 @@ namespace stm
       uint32_t max;
 
       /*** how many hourglass commits occurred? */
-      uint32_t hg_commits;
+      uint64_t hg_commits;
 
       /*** how many hourglass aborts occurred? */
-      uint32_t hg_aborts;
+      uint64_t hg_aborts;
 
       /*** histogram with 0-16 + overflow */
-      uint32_t buckets[18];
+      uint64_t buckets[18];
 
       /*** on commit, update the appropriate bucket */
       void onCommit(uint32_t aborts);
@@ -0,0 +1,139 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Per-phase cost breakdown from hardware performance counters.
+ *
+ *  When libstm is built with libstm_enable_perf, and the STM_PERF
+ *  environment variable is set, every thread opens cycle, instruction and
+ *  last-level-cache-miss counters with perf_event_open, and charges the
+ *  change in each counter to the phase that the thread was in: inside the
+ *  begin, read, write or commit barrier, validating, rolling back (from the
+ *  abort until the retry begins), running the transaction's own code, or
+ *  outside of any transaction.  Counters are read with rdpmc when the kernel
+ *  allows it, so a phase change costs tens of cycles rather than a system
+ *  call.
+ *
+ *  Counters that cannot be opened (no PMU, as in many VMs, or a restrictive
+ *  perf_event_paranoid setting) are reported as unavailable, and cycles fall
+ *  back to tick(), which counts reference cycles of wall time.
+ *
+ *  The totals are printed by sys_shutdown, and are available to programs
+ *  through get_perf_counters(), which is how the benchmark harness puts them
+ *  in its JSON.
+ */
+
+#ifndef STM_PERF_HPP__
+#define STM_PERF_HPP__
+
+#include <stm/config.h>
+#include <stdint.h>
+
+namespace stm
+{
+  /*** The phases that costs are charged to */
+  enum perf_phase_t {
+      PERF_NONTX,       // outside of any transaction
+      PERF_BEGIN,       // in the begin barrier (including waiting)
+      PERF_BODY,        // in the transaction, outside of the barriers
+      PERF_READ,        // in a read barrier
+      PERF_WRITE,       // in a write barrier
+      PERF_COMMIT,      // in the commit barrier
+      PERF_VALIDATE,    // validating the read set, from any barrier
+      PERF_ABORT,       // from an abort until the retry begins
+      PERF_PHASES
+  };
+
+  /*** The counters we collect */
+  enum perf_counter_t {
+      PERF_CYCLES,
+      PERF_INSTRUCTIONS,
+      PERF_LLC_MISSES,
+      PERF_COUNTERS
+  };
+
+  /*** Totals of every counter for every phase */
+  struct perf_totals_t
+  {
+      uint64_t value[PERF_PHASES][PERF_COUNTERS];
+      uint64_t entries[PERF_PHASES];      // times the phase was entered
+      bool     available[PERF_COUNTERS];  // false: the value is meaningless
+      bool     hw_cycles;                 // false: cycles come from tick()
+  };
+
+  /*** names of the phases and counters, for reports */
+  extern const char* const perf_phase_names[PERF_PHASES];
+  extern const char* const perf_counter_names[PERF_COUNTERS];
+} // namespace stm
+
+#ifdef STM_PERF
+
+#include <stm/txthread.hpp>
+
+namespace stm
+{
+  /*** check STM_PERF (called from sys_init) */
+  void perf_init();
+
+  /*** open the calling thread's counters, or NULL if we are not counting */
+  perf_state_t* perf_open();
+
+  /**
+   *  Charge the counters since the last switch to the current phase, and
+   *  enter phase p.  'entering' is false when we are returning to a phase
+   *  rather than starting a new instance of it.
+   */
+  perf_phase_t perf_switch(TxThread* tx, perf_phase_t p, bool entering)
+      NOINLINE;
+
+  /*** print the totals (called from sys_shutdown) */
+  void perf_report();
+
+  /**
+   *  Sum the counters of thread 'id' (1-based), or of all threads if id is
+   *  0.  Returns false if counters are not being collected.
+   */
+  bool get_perf_counters(perf_totals_t* out, uint32_t id = 0);
+
+  /*** enter phase p, and return the phase we were in */
+  TM_INLINE
+  inline perf_phase_t perf_enter(TxThread* tx, perf_phase_t p)
+  {
+      return tx->perf ? perf_switch(tx, p, true) : p;
+  }
+
+  /*** go back to phase p, which perf_enter returned */
+  TM_INLINE
+  inline void perf_leave(TxThread* tx, perf_phase_t p)
+  {
+      if (tx->perf)
+          perf_switch(tx, p, false);
+  }
+} // namespace stm
+
+/**
+ *  Nothing restores the phase on the way out of an abort: the rollback has
+ *  already moved the thread to PERF_ABORT.  We do not use a destructor for
+ *  this, since longjmp may skip it.
+ */
+#define STM_PERF_PHASE(tx, p) stm::perf_enter(tx, p)
+#define STM_PERF_ENTER(tx, p) \
+    stm::perf_phase_t perf_old_phase_ = stm::perf_enter(tx, p)
+#define STM_PERF_LEAVE(tx)    stm::perf_leave(tx, perf_old_phase_)
+
+#else
+
+#define STM_PERF_PHASE(tx, p)
+#define STM_PERF_ENTER(tx, p)
+#define STM_PERF_LEAVE(tx)
+
+#endif // STM_PERF
+
+#endif // STM_PERF_HPP__
@@ -0,0 +1,89 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Runtime statistics.
+ *
+ *  get_stats() sums the per-thread counters into a stats_t while the threads
+ *  keep running.  Each counter is written only by its own thread, so a
+ *  snapshot is not a consistent cut (commits and aborts may be off by the
+ *  transactions in flight), but every counter is 64 bits and never goes
+ *  backwards.  On 32-bit platforms a counter may be read torn while it
+ *  carries into its high word.
+ *
+ *  When libstm is built with libstm_enable_stats_export, and the
+ *  STM_STATS_FILE environment variable names a file, a background thread
+ *  rewrites that file every STM_STATS_INTERVAL milliseconds (default 1000)
+ *  with the latest snapshot, as JSON or, if STM_STATS_FORMAT=prometheus, in
+ *  the Prometheus text exposition format.  The file is written to a
+ *  temporary name and renamed, so readers never see a partial snapshot.
+ */
+
+#ifndef STM_STATS_HPP__
+#define STM_STATS_HPP__
+
+#include <stm/config.h>
+#include <cstdio>
+#include <stdint.h>
+
+namespace stm
+{
+  /*** buckets of the consecutive-abort histogram: 0..16, and 17+ */
+  const uint32_t STATS_ABORT_BUCKETS = 18;
+
+  /*** A snapshot of the whole library */
+  struct stats_t
+  {
+      const char* algorithm;        // the algorithm in use now
+      const char* policy;           // the adaptivity policy in use now
+      uint64_t    policy_switches;  // algorithm switches since sys_init
+      uint32_t    threads;          // threads that have called thread_init
+      uint64_t    commits_rw;       // writing transactions committed
+      uint64_t    commits_ro;       // read-only transactions committed
+      uint64_t    aborts;           // aborted attempts
+      uint64_t    restarts;         // explicit restart()s
+      uint64_t    validations;      // read set validations
+      bool        validations_valid; // false if the algorithm doesn't count
+      uint64_t    time_ns;          // when the snapshot was taken
+
+      /**
+       *  Committed transactions by how many times they aborted first.  Only
+       *  maintained when libstm is built with
+       *  libstm_enable_abort_histogram; if not, abort_hist_valid is false
+       *  and the buckets are zero.
+       */
+      bool        abort_hist_valid;
+      uint64_t    abort_hist[STATS_ABORT_BUCKETS];
+      uint32_t    abort_hist_max;   // most consecutive aborts, if over 16
+  };
+
+  /**
+   *  Fill 's' with the current totals.  This does not block transactions,
+   *  and may be called from any thread, including one that never called
+   *  thread_init.
+   */
+  void get_stats(stats_t* s);
+
+  /*** print a snapshot as one JSON object */
+  void write_stats_json(FILE* out, const stats_t& s);
+
+  /*** print a snapshot in the Prometheus text exposition format */
+  void write_stats_prometheus(FILE* out, const stats_t& s);
+
+#ifdef STM_STATS_EXPORT
+  /*** start the reporter thread, if STM_STATS_FILE is set (from sys_init) */
+  void stats_export_init();
+
+  /*** write a final snapshot and stop the reporter (from sys_shutdown) */
+  void stats_export_shutdown();
+#endif
+} // namespace stm
+
+#endif // STM_STATS_HPP__
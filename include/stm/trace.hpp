@@ -0,0 +1,150 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Transaction traces.
+ *
+ *  When libstm is built with libstm_enable_trace, and the STM_TRACE
+ *  environment variable names a file prefix, every thread writes the stream
+ *  of begin/read/write/commit/abort events of its transactions to the file
+ *  <prefix>.<thread id>.  Events are logged into a per-thread chunk, and
+ *  full chunks are handed to a background thread that writes them out, so
+ *  the only cost on the transaction's path is filling in one record.
+ *
+ *  A trace file is a trace_header_t followed by trace_rec_t's, in the byte
+ *  order and word size of the machine that wrote it.  Reads and writes are
+ *  logged at the API (the address and size of each TM_READ, TM_WRITE, tvar
+ *  access, and each chunk of a bulk memory operation), so that the trace
+ *  does not depend on the algorithm that was running.  ReplayBench re-runs
+ *  a set of traces against any algorithm, at any thread count.
+ *
+ *  The format definitions are always available, so that tools can read
+ *  traces even when tracing is not compiled into the library.
+ */
+
+#ifndef STM_TRACE_HPP__
+#define STM_TRACE_HPP__
+
+#include <stm/config.h>
+#include <stdint.h>
+#include <cstddef>
+
+namespace stm
+{
+  /*** The kinds of event that a trace records */
+  enum trace_kind_t {
+      TRACE_BEGIN    = 0,       // outermost begin of an attempt
+      TRACE_BEGIN_RO = 1,       // same, for a declared read-only transaction
+      TRACE_READ     = 2,
+      TRACE_WRITE    = 3,
+      TRACE_COMMIT   = 4,
+      TRACE_ABORT    = 5
+  };
+
+  /**
+   *  One event.  delta is the number of tick()s since the thread's previous
+   *  event (saturated at 2^32-1), and info packs the kind into its low 4
+   *  bits and the size of the access, in bytes, into the rest.
+   */
+  struct trace_rec_t
+  {
+      uint64_t addr;
+      uint32_t delta;
+      uint32_t info;
+
+      trace_kind_t kind() const { return (trace_kind_t)(info & 0xF); }
+      uint32_t     size() const { return info >> 4; }
+  };
+
+  /*** The start of every trace file */
+  struct trace_header_t
+  {
+      char     magic[8];        // "RSTMTRC"
+      uint32_t version;         // TRACE_VERSION
+      uint32_t thread;          // id of the TxThread that wrote it
+      uint32_t word_bytes;      // sizeof(void*) of the writer
+      uint32_t rec_bytes;       // sizeof(trace_rec_t) of the writer
+  };
+
+  static const uint32_t TRACE_VERSION = 1;
+
+  /*** records per chunk; a chunk is the unit of asynchronous flushing */
+  static const uint32_t TRACE_CHUNK_RECS = 8192;
+
+  /*** a thread's current chunk */
+  struct trace_buf_t
+  {
+      trace_rec_t* recs;
+      uint32_t     count;
+      uint64_t     last;        // tick() of the previous event
+  };
+} // namespace stm
+
+#ifdef STM_TRACE
+
+#include <common/platform.hpp>
+#include <stm/txthread.hpp>
+
+namespace stm
+{
+  /*** start the writer thread, if STM_TRACE is set (called from sys_init) */
+  void trace_init();
+
+  /*** give a new thread its trace file, or NULL if we are not tracing */
+  trace_buf_t* trace_open(uint32_t id);
+
+  /*** hand a full chunk to the writer, and get an empty one */
+  void trace_flush(TxThread* tx) NOINLINE;
+
+  /*** flush every thread's partial chunk, and stop tracing */
+  void trace_shutdown();
+
+  /*** log one event for tx */
+  TM_INLINE
+  inline void trace_event(TxThread* tx, trace_kind_t kind, const void* addr,
+                          size_t size)
+  {
+      trace_buf_t* b = tx->trace;
+      if (!b)
+          return;
+      uint64_t now = tick();
+      uint64_t delta = now - b->last;
+      trace_rec_t& r = b->recs[b->count];
+      r.addr  = (uint64_t)(uintptr_t)addr;
+      r.delta = (delta > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (uint32_t)delta;
+      r.info  = (uint32_t)kind | ((uint32_t)size << 4);
+      b->last = now;
+      if (++b->count == TRACE_CHUNK_RECS)
+          trace_flush(tx);
+  }
+
+  /*** log a read or write, unless it is outside of a transaction */
+  TM_INLINE
+  inline void trace_access(TxThread* tx, trace_kind_t kind, const void* addr,
+                           size_t size)
+  {
+      if (tx->nesting_depth)
+          trace_event(tx, kind, addr, size);
+  }
+} // namespace stm
+
+#define STM_TRACE_EVENT(tx, kind, addr, size)  \
+    stm::trace_event(tx, kind, addr, size)
+#define STM_TRACE_ACCESS(tx, kind, addr, size) \
+    stm::trace_access(tx, kind, addr, size)
+
+#else
+
+#define STM_TRACE_EVENT(tx, kind, addr, size)
+#define STM_TRACE_ACCESS(tx, kind, addr, size)
+
+#endif // STM_TRACE
+
+#endif // STM_TRACE_HPP__
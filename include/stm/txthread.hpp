@@ -28,6 +28,9 @@
 
 namespace stm
 {
+  struct trace_buf_t;
+  struct perf_state_t;
+
   /**
    *  The TxThread struct holds all of the metadata that a thread needs in
    *  order to use any of the STM algorithms we support.  In the past, this
@@ -48,10 +51,11 @@ namespace stm
       uint32_t       id;            // per thread id
       uint32_t       nesting_depth; // nesting; 0 == not in transaction
       WBMMPolicy     allocator;     // buffer malloc/free
-      uint32_t       num_commits;   // stats counter: commits
-      uint32_t       num_aborts;    // stats counter: aborts
-      uint32_t       num_restarts;  // stats counter: restart()s
-      uint32_t       num_ro;        // stats counter: read-only commits
+      uint64_t       num_commits;   // stats counter: commits
+      uint64_t       num_aborts;    // stats counter: aborts
+      uint64_t       num_restarts;  // stats counter: restart()s
+      uint64_t       num_ro;        // stats counter: read-only commits
+      uint64_t       num_validations; // stats counter: read set validations
       scope_t* volatile scope;      // used to roll back; also flag for isTxnl
 #ifdef STM_PROTECT_STACK
       void**         stack_high;    // the stack pointer at begin_tx time
@@ -60,11 +64,13 @@ namespace stm
       uintptr_t      start_time;    // start time of transaction
       uintptr_t      end_time;      // end time of transaction
       uintptr_t      ts_cache;      // last validation time
+      int32_t        extend_credit; // extension credit (LLTExtend)
       bool           tmlHasLock;    // is tml thread holding the lock
       UndoLog        undo_log;      // etee undo log
       ValueList      vlist;         // NOrec read log
       WriteSet       writes;        // write set
       OrecList       r_orecs;       // read set for orec STMs
+      RegionReadList r_regions;     // read set for OrecLazyRegion
       OrecList       locks;         // list of all locks held by tx
       id_version_t   my_lock;       // lock word for orec STMs
       filter_t*      wf;            // write filter
@@ -74,21 +80,38 @@ namespace stm
       uint32_t       seed;          // for randomized backoff
       RRecList       myRRecs;       // indices of rrecs I set
       intptr_t       order;         // for stms that order txns eagerly
+      int32_t        det_lane;      // lane in PipelineDet, or -1
       volatile uint32_t alive;      // for STMs that allow remote abort
       ByteLockList   r_bytelocks;   // list of all byte locks held for read
       ByteLockList   w_bytelocks;   // all byte locks held for write
       BitLockList    r_bitlocks;    // list of all bit locks held for read
       BitLockList    w_bitlocks;    // list of all bit locks held for write
       mcs_qnode_t*   my_mcslock;    // for MCS
+      uint32_t       numa_node;     // for cohort locks
       uintptr_t      valid_ts;      // the validation timestamp for each tx
       uintptr_t      cm_ts;         // the contention manager timestamp
+      uintptr_t      cm_karma;      // work of aborted attempts (Karma, Polka)
+      volatile uint32_t cm_waiting; // waiting on an older tx (Greedy)
+      volatile uint32_t cm_winner;  // id of the tx that last killed us
       filter_t*      cf;            // conflict filter (RingALA)
       NanorecList    nanorecs;      // list of nanorecs held
       uint32_t       consec_commits;// count consec commits
+      filter_t*      shrink_wsig;   // last write set (ShrinkCM)
+      filter_t*      shrink_pred;   // predicted write set of retry (ShrinkCM)
+      volatile uint32_t shrink_waiting; // queued behind another tx (ShrinkCM)
+      bool           shrink_hot;    // counted in shrink_hot (ShrinkCM)
       toxic_t        abort_hist;    // for counting poison
       uint32_t       begin_wait;    // how long did last tx block at begin
       bool           strong_HG;     // for strong hourglass
       bool           irrevocable;   // tells begin_blocker that I'm THE ONE
+      CallbackList   commit_handlers; // run after commit
+      CallbackList   abort_handlers;  // run after rollback
+#ifdef STM_TRACE
+      trace_buf_t*   trace;         // event log; NULL when not tracing
+#endif
+#ifdef STM_PERF
+      perf_state_t*  perf;          // phase counters; NULL when not counting
+#endif
 
       /*** PER-THREAD FIELDS FOR ENABLING ADAPTIVITY POLICIES */
       uint64_t      end_txn_time;      // end of non-transactional work
@@ -121,6 +144,29 @@ namespace stm
       TM_FASTCALL void*(*tmread)(STM_READ_SIG(,,));
       TM_FASTCALL void(*tmwrite)(STM_WRITE_SIG(,,,));
 
+      /**
+       * Per-thread read and write pointers for tvar<T> objects, which carry
+       * their own orec.  Algorithms that do not use orecs install barriers
+       * that simply forward to tmread/tmwrite.
+       */
+      TM_FASTCALL void*(*tmread_obj)(STM_READ_OBJ_SIG(,,));
+      TM_FASTCALL void(*tmwrite_obj)(STM_WRITE_OBJ_SIG(,,,));
+
+      /**
+       * Per-thread pointers for reading and writing runs of whole words, as
+       * used by tx_memcpy, tx_memset and tx_memcmp.
+       */
+      void(*tmread_block)(STM_READ_BLOCK_SIG(,,,));
+      void(*tmwrite_block)(STM_WRITE_BLOCK_SIG(,,,));
+
+      /**
+       * The read and commit barriers of the current algorithm for
+       * transactions that were declared read-only.  tmread_ronly is NULL if
+       * the algorithm has no such barriers.
+       */
+      static TM_FASTCALL void*(*tmread_ronly)(STM_READ_SIG(,,));
+      static TM_FASTCALL void(*tmcommit_ronly)(TxThread*);
+
       /**
        * Some APIs, in particular the itm API at the moment, want to be able
        * to rollback the top level of nesting without actually unwinding the
@@ -137,8 +183,14 @@ namespace stm
        *
        * Some advanced APIs may not want a NORETURN abort function, but the stm
        * library at the moment only handles this option.
+       *
+       * tmabort is per-thread, so that a transaction that cannot abort (such
+       * as an inevitable one) can trap aborts without affecting anyone else.
+       * abort_handler is the configured handler, which every thread starts
+       * with and goes back to.
        */
-      static NORETURN void (*tmabort)(TxThread*);
+      NORETURN void (*tmabort)(TxThread*);
+      static NORETURN void (*abort_handler)(TxThread*);
 
       /*** how to become irrevocable in-flight */
       static bool(*tmirrevoc)(TxThread*);
@@ -97,6 +97,46 @@ option(
   "ON enables a histogram of consecutive aborts" OFF)
 #mark_as_advanced(libstm_enable_abort_histogram)
 
+## Experimental: record every transaction's begin/read/write/commit/abort
+##               events to per-thread files, for offline replay (see
+##               stm/trace.hpp).  When compiled in, tracing is still off
+##               unless the STM_TRACE environment variable is set.
+option(
+  libstm_enable_trace
+  "ON to compile in transaction tracing (enabled by STM_TRACE=<prefix>)" OFF)
+mark_as_advanced(libstm_enable_trace)
+
+## Experimental: charge cycles, instructions and last-level cache misses to
+##               the begin/read/write/commit/validate/abort phases of each
+##               thread, using perf_event_open (see stm/perf.hpp).  When
+##               compiled in, counting is still off unless the STM_PERF
+##               environment variable is set.
+option(
+  libstm_enable_perf
+  "ON to compile in per-phase performance counters (enabled by STM_PERF=1)" OFF)
+mark_as_advanced(libstm_enable_perf)
+
+## Monitoring: a background thread that periodically writes the counters
+##             from stm::get_stats() to a file, as JSON or Prometheus text
+##             (see stm/stats.hpp).  When compiled in, it is still off unless
+##             the STM_STATS_FILE environment variable is set.
+option(
+  libstm_enable_stats_export
+  "ON to compile in the stats reporter (enabled by STM_STATS_FILE=<file>)" OFF)
+mark_as_advanced(libstm_enable_stats_export)
+
+## Overhead: how many bytes each orec covers.  Orecs are indexed by address
+##           >> STM_OREC_SHIFT, so with 'line' all of the words in a cache
+##           line share an orec: a transaction that reads a whole line logs
+##           and validates one orec, at the cost of false conflicts between
+##           writers to different words of the line.  This affects every
+##           orec-based algorithm.
+libstm_enum(
+  libstm_orec_granularity word
+  "The number of bytes covered by each orec"
+  word;16;line;page)
+mark_as_advanced(libstm_orec_granularity)
+
 ## Overhead: The C++ TM Draft Standard requires byte-level granularity of
 ##           instrumentation since tx/nontx accesses to adjacent bytes are
 ##           allowed.  This is forced on when building the shim, and usually
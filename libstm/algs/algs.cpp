@@ -34,6 +34,9 @@ namespace stm
   /*** the set of orecs (locks) */
   orec_t orecs[NUM_STRIPES] = {{{{0}}}};
 
+  /*** the region summaries of the orecs */
+  region_t regions[NUM_REGIONS] = {{0}};
+
   /*** the set of nanorecs */
   orec_t nanorecs[RING_ELEMENTS] = {{{{0}}}};
 
@@ -64,9 +67,20 @@ namespace stm
   /*** for Ticket */
   ticket_lock_t ticketlock  = {0};
 
+  /*** for CohortCGL, CohortMCS and CohortTicket */
+  cohort_tatas_lock_t  cohorttataslock  = {0};
+  cohort_mcs_lock_t    cohortmcslock    = {0};
+  cohort_ticket_lock_t cohortticketlock = {{0}};
+
   /*** for some CMs */
   pad_word_t fcm_timestamp = {0};
 
+  /*** number of threads that ShrinkCM is scheduling */
+  pad_word_t shrink_hot = {0};
+
+  /*** id of the concurrent inevitable transaction, or 0 */
+  pad_word_t inev_token = {0};
+
   /*** Store descriptions of the STM algorithms */
   alg_t stms[ALG_MAX];
 
@@ -86,4 +100,30 @@ namespace stm
       return -1;
   }
 
+  /*** tvar<T> read for algorithms that do not use per-object orecs */
+  void* read_obj_fallback(STM_READ_OBJ_SIG(tx,,addr))
+  {
+      return tx->tmread(tx, addr STM_MASK(~0x0));
+  }
+
+  /*** tvar<T> write for algorithms that do not use per-object orecs */
+  void write_obj_fallback(STM_WRITE_OBJ_SIG(tx,,addr,val))
+  {
+      tx->tmwrite(tx, addr, val STM_MASK(~0x0));
+  }
+
+  /*** block read for algorithms that cannot batch their metadata work */
+  void read_block_fallback(STM_READ_BLOCK_SIG(tx,to,addr,words))
+  {
+      for (size_t i = 0; i < words; ++i)
+          to[i] = tx->tmread(tx, addr + i STM_MASK(~0x0));
+  }
+
+  /*** block write for algorithms that cannot batch their metadata work */
+  void write_block_fallback(STM_WRITE_BLOCK_SIG(tx,addr,from,words))
+  {
+      for (size_t i = 0; i < words; ++i)
+          tx->tmwrite(tx, addr + i, from[i] STM_MASK(~0x0));
+  }
+
 } // namespace stm
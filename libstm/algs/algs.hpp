@@ -25,6 +25,8 @@
 
 #include "stm/metadata.hpp"
 #include "stm/txthread.hpp"
+#include "stm/trace.hpp"
+#include "stm/perf.hpp"
 #include "../profiling.hpp" // Trigger::
 
 namespace stm
@@ -39,13 +41,19 @@ namespace stm
       OrecELA, TMLLazy, NOrecPrio, OrecFair, CToken, CTokenTurbo, Pipeline,
       BitLazy, LLT, TLI, ByteEager, MCS, Serial, BitEager, ByteLazy,
       ByEAR, OrecEagerRedo, ByteEagerRedo, BitEagerRedo,
-      RingALA, Nano, Swiss,
+      RingALA, Nano, Swiss, NOrecFC, CohortMCS, CohortTicket,
+      PipelineDet, OrecLazyRegion, LLTExtend, RingMW, TLIGroup,
+      NOrecHint, CohortCGL,
 
       ByEAUBackoff, ByEAUFCM, ByEAUNoBackoff, ByEAUHour,
+      ByEAUKarma,   ByEAUPolka, ByEAUGreedy,
       OrEAUBackoff, OrEAUFCM, OrEAUNoBackoff, OrEAUHour,
+      OrEAUKarma,   OrEAUPolka, OrEAUGreedy,
       OrecEager, OrecEagerHour, OrecEagerBackoff, OrecEagerHB,
       OrecLazy,  OrecLazyHour,  OrecLazyBackoff,  OrecLazyHB,
+      OrecLazyShrink,
       NOrec,     NOrecHour,     NOrecBackoff,     NOrecHB,
+      NOrecShrink,
       // ProfileTM support.  These are not true STMs
       ProfileTM, ProfileAppAvg, ProfileAppMax, ProfileAppAll,
       // end with a distinct value
@@ -55,6 +63,8 @@ namespace stm
    *  These constants are used throughout the STM implementations
    */
   static const uint32_t NUM_STRIPES   = 1048576;  // number of orecs
+  static const uint32_t REGION_ORECS  = 64;       // orecs per region
+  static const uint32_t NUM_REGIONS   = NUM_STRIPES / REGION_ORECS;
   static const uint32_t RING_ELEMENTS = 1024;     // number of ring elements
   static const uint32_t KARMA_FACTOR  = 16;       // aborts b4 incr karma
   static const uint32_t BACKOFF_MIN   = 4;        // min backoff exponent
@@ -72,6 +82,7 @@ namespace stm
    */
   extern pad_word_t    timestamp;
   extern orec_t        orecs[NUM_STRIPES];             // set of orecs
+  extern region_t      regions[NUM_REGIONS];           // orec summaries
   extern pad_word_t    last_init;                      // last logical commit
   extern pad_word_t    last_complete;                  // last physical commit
   extern filter_t ring_wf[RING_ELEMENTS] TM_ALIGN(16); // ring of Bloom filters
@@ -83,15 +94,33 @@ namespace stm
   extern mcs_qnode_t*  mcslock;                        // for MCS
   extern pad_word_t    epochs[MAX_THREADS];            // for coarse-grained CM
   extern ticket_lock_t ticketlock;                     // for ticket lock STM
+  extern cohort_tatas_lock_t  cohorttataslock;         // for CohortCGL
+  extern cohort_mcs_lock_t    cohortmcslock;           // for CohortMCS
+  extern cohort_ticket_lock_t cohortticketlock;        // for CohortTicket
   extern orec_t        nanorecs[RING_ELEMENTS];        // for Nano
   extern pad_word_t    greedy_ts;                      // for swiss cm
   extern pad_word_t    fcm_timestamp;                  // for FCM
+  extern pad_word_t    shrink_hot;                     // for ShrinkCM
   extern dynprof_t*    app_profiles;                   // for ProfileApp*
+  extern pad_word_t    inev_token;                     // inevitable tx id
 
   // ProfileTM can't function without these
   extern dynprof_t*    profiles;          // a list of ProfileTM measurements
   extern uint32_t      profile_txns;      // how many txns per profile
 
+  /**
+   *  Default tvar<T> barriers: ignore the embedded orec and use the thread's
+   *  current address-based barriers on the tvar's data word
+   */
+  TM_FASTCALL void* read_obj_fallback(STM_READ_OBJ_SIG(,,));
+  TM_FASTCALL void write_obj_fallback(STM_WRITE_OBJ_SIG(,,,));
+
+  /**
+   *  Default block barriers: one call to the thread's word barrier per word
+   */
+  void read_block_fallback(STM_READ_BLOCK_SIG(,,,));
+  void write_block_fallback(STM_WRITE_BLOCK_SIG(,,,));
+
   /**
    *  To describe an STM algorithm, we provide a name, a set of function
    *  pointers, and some other information
@@ -110,6 +139,32 @@ namespace stm
       void* (*TM_FASTCALL read)  (STM_READ_SIG(,,));
       void  (*TM_FASTCALL write) (STM_WRITE_SIG(,,,));
 
+      /**
+       * read and write barriers for tvar<T> objects.  These default to
+       * forwarding to the per-thread address-based barriers, so only
+       * orec-based algorithms need to provide them.
+       */
+      void* (*TM_FASTCALL read_obj)  (STM_READ_OBJ_SIG(,,));
+      void  (*TM_FASTCALL write_obj) (STM_WRITE_OBJ_SIG(,,,));
+
+      /**
+       * read and write barriers for runs of whole words.  These default to
+       * looping over the per-thread word barriers, so algorithms only
+       * provide them when they can batch the metadata work.
+       */
+      void  (* read_block) (STM_READ_BLOCK_SIG(,,,));
+      void  (* write_block)(STM_WRITE_BLOCK_SIG(,,,));
+
+      /**
+       * read and commit barriers for transactions declared read-only via
+       * TM_BEGIN(readonly).  When read_ronly is NULL, such transactions just
+       * use the starting barriers, which is right for algorithms that start
+       * every transaction in a read-only mode (e.g., NOrec and OrecLazy).
+       * When commit_ronly is NULL, the starting commit barrier is used.
+       */
+      void* (*TM_FASTCALL read_ronly)  (STM_READ_SIG(,,));
+      void  (*TM_FASTCALL commit_ronly)(TxThread*);
+
       /**
        * rolls the transaction back without unwinding, returns the scope (which
        * is set to null during rollback)
@@ -119,6 +174,20 @@ namespace stm
       /*** the restart, retry, and irrevoc methods to use */
       bool  (* irrevoc)(TxThread*);
 
+      /**
+       * become inevitable without blocking other transactions, or return
+       * false (in which case the caller aborts).  NULL if the algorithm
+       * only supports irrevocability by serializing all transactions.
+       */
+      bool  (* become_inev)(TxThread*);
+
+      /**
+       * the read barrier of the algorithm's turbo mode, in which a
+       * transaction writes in place and can no longer abort.  NULL if the
+       * algorithm has no turbo mode.
+       */
+      void* (*TM_FASTCALL read_turbo)(STM_READ_SIG(,,));
+
       /*** the code to run when switching to this alg */
       void  (* switcher) ();
 
@@ -130,8 +199,16 @@ namespace stm
        */
       bool privatization_safe;
 
+      /*** true if the algorithm counts its read set validations */
+      bool counts_validations;
+
       /*** simple ctor, because a NULL name is a bad thing */
-      alg_t() : name("") { }
+      alg_t() : name(""), read_obj(read_obj_fallback),
+                write_obj(write_obj_fallback),
+                read_block(read_block_fallback),
+                write_block(write_block_fallback),
+                read_ronly(NULL), commit_ronly(NULL), become_inev(NULL),
+                read_turbo(NULL), counts_validations(false) { }
   };
 
   /**
@@ -140,13 +217,25 @@ namespace stm
    */
 
   /**
-   *  Map addresses to orec table entries
+   *  Map addresses to orec table entries.  Each orec covers
+   *  2^STM_OREC_SHIFT bytes (see libstm_orec_granularity)
    */
   TM_INLINE
   inline orec_t* get_orec(void* addr)
   {
       uintptr_t index = reinterpret_cast<uintptr_t>(addr);
-      return &orecs[(index>>3) % NUM_STRIPES];
+      return &orecs[(index>>STM_OREC_SHIFT) % NUM_STRIPES];
+  }
+
+  /**
+   *  Map orecs to the index of the region that summarizes them.  Region i
+   *  covers orecs [i*REGION_ORECS, (i+1)*REGION_ORECS), which are
+   *  consecutive stripes of memory, so a region covers REGION_ORECS stripes.
+   */
+  TM_INLINE
+  inline uint32_t get_region_index(orec_t* o)
+  {
+      return (o - orecs) / REGION_ORECS;
   }
 
   /**
@@ -176,7 +265,7 @@ namespace stm
   inline bytelock_t* get_bytelock(void* addr)
   {
       uintptr_t index = reinterpret_cast<uintptr_t>(addr);
-      return &bytelocks[(index>>3) % NUM_STRIPES];
+      return &bytelocks[(index>>STM_OREC_SHIFT) % NUM_STRIPES];
   }
 
   /**
@@ -186,7 +275,7 @@ namespace stm
   inline bitlock_t* get_bitlock(void* addr)
   {
       uintptr_t index = reinterpret_cast<uintptr_t>(addr);
-      return &bitlocks[(index>>3) % NUM_STRIPES];
+      return &bitlocks[(index>>STM_OREC_SHIFT) % NUM_STRIPES];
   }
 
   /**
@@ -293,6 +382,8 @@ namespace stm
 
   inline void PreRollback(TxThread* tx)
   {
+      STM_TRACE_EVENT(tx, TRACE_ABORT, NULL, 0);
+      STM_PERF_PHASE(tx, PERF_ABORT);
       ++tx->num_aborts;
       ++tx->consec_aborts;
   }
@@ -484,8 +575,9 @@ namespace stm
   {
       printf("abort_histogram: ");
       for (int i = 0; i < 18; ++i)
-          printf("%d, ", buckets[i]);
-      printf("max = %d, hgc = %d, hga = %d\n", max, hg_commits, hg_aborts);
+          printf("%llu, ", (unsigned long long)buckets[i]);
+      printf("max = %u, hgc = %llu, hga = %llu\n", max,
+             (unsigned long long)hg_commits, (unsigned long long)hg_aborts);
   }
 
   /*** on hourglass commit */
@@ -360,13 +360,14 @@ namespace {
       foreach (ByteLockList, j, tx->r_bytelocks)
           (*j)->reader[tx->id-1] = 0;
 
+      // notify CM before resetting lists, so it can see the work we lost
+      CM::onAbort(tx);
+
       // reset lists
       tx->r_bytelocks.reset();
       tx->w_bytelocks.reset();
       tx->undo_log.reset();
 
-      CM::onAbort(tx);
-
       return PostRollback(tx, read_ro, write_ro, commit_ro);
   }
 
@@ -397,7 +398,10 @@ namespace {
     MACRO(ByEAUBackoff, BackoffCM)                     \
     MACRO(ByEAUNoBackoff, HyperAggressiveCM)           \
     MACRO(ByEAUFCM, FCM)                        \
-    MACRO(ByEAUHour, HourglassCM)
+    MACRO(ByEAUHour, HourglassCM)               \
+    MACRO(ByEAUKarma, KarmaCM)                  \
+    MACRO(ByEAUPolka, PolkaCM)                  \
+    MACRO(ByEAUGreedy, GreedyCM)
 
 #define INIT_BYEAU(ID, CM)                      \
     template <>                                 \
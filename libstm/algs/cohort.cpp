@@ -0,0 +1,259 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  CohortCGL, CohortMCS and CohortTicket Implementations
+ *
+ *    These STMs are like CGL, MCS and Ticket, except that the single lock is
+ *    a NUMA-aware cohort lock (see common/locks.hpp).  CohortCGL uses C-BO-BO
+ *    (TATAS locks with backoff per node and globally), CohortMCS uses
+ *    C-BO-MCS (an MCS lock per node, and a global TATAS lock with backoff),
+ *    and CohortTicket uses C-TKT-TKT (ticket locks per node and globally).
+ *    Unlike CGL, CohortCGL does not use the timestamp as its lock.  While
+ *    threads on one node are waiting, the lock is handed among them, up to
+ *    COHORT_PASS_LIMIT times, so the data that transactions touch does not
+ *    bounce between nodes as often.  There is still no parallelism, and the
+ *    lock is fair across nodes, but not within a batch.
+ */
+
+#include "../profiling.hpp"
+#include "algs.hpp"
+#include <stm/UndoLog.hpp> // STM_DO_MASKED_WRITE
+
+using stm::UNRECOVERABLE;
+using stm::TxThread;
+using stm::cohorttataslock;
+using stm::cohortmcslock;
+using stm::cohortticketlock;
+
+
+/**
+ *  Declare the functions that we're going to implement, so that we can avoid
+ *  circular dependencies.
+ */
+namespace  {
+  struct CohortCGL
+  {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void commit(TxThread*);
+  };
+
+  struct CohortMCS
+  {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void commit(TxThread*);
+  };
+
+  struct CohortTicket
+  {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void commit(TxThread*);
+  };
+
+  /**
+   *  The algorithms differ only in begin and commit, so they share the
+   *  remaining functions.
+   */
+  struct Cohort
+  {
+      static TM_FASTCALL void* read(STM_READ_SIG(,,));
+      static TM_FASTCALL void write(STM_WRITE_SIG(,,,));
+
+      static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool irrevoc(TxThread*);
+      static void onSwitchTo();
+  };
+
+  /**
+   *  CohortCGL begin:
+   */
+  bool
+  CohortCGL::begin(TxThread* tx)
+  {
+      // acquire the cohort lock
+      tx->begin_wait = cohort_tatas_acquire(&cohorttataslock, tx->numa_node);
+      tx->allocator.onTxBegin();
+      return true;
+  }
+
+  /**
+   *  CohortCGL commit
+   */
+  void
+  CohortCGL::commit(TxThread* tx)
+  {
+      // release the lock, finalize mm ops, and log the commit
+      cohort_tatas_release(&cohorttataslock, tx->numa_node);
+      OnCGLCommit(tx);
+  }
+
+  /**
+   *  CohortMCS begin:
+   */
+  bool
+  CohortMCS::begin(TxThread* tx)
+  {
+      // acquire the cohort lock, queueing on our node's MCS lock
+      tx->begin_wait = cohort_mcs_acquire(&cohortmcslock, tx->numa_node,
+                                          tx->my_mcslock);
+      tx->allocator.onTxBegin();
+      return true;
+  }
+
+  /**
+   *  CohortMCS commit
+   */
+  void
+  CohortMCS::commit(TxThread* tx)
+  {
+      // release the lock, finalize mm ops, and log the commit
+      cohort_mcs_release(&cohortmcslock, tx->numa_node, tx->my_mcslock);
+      OnCGLCommit(tx);
+  }
+
+  /**
+   *  CohortTicket begin:
+   */
+  bool
+  CohortTicket::begin(TxThread* tx)
+  {
+      // acquire the cohort lock
+      tx->begin_wait = cohort_ticket_acquire(&cohortticketlock,
+                                             tx->numa_node);
+      tx->allocator.onTxBegin();
+      return true;
+  }
+
+  /**
+   *  CohortTicket commit
+   */
+  void
+  CohortTicket::commit(TxThread* tx)
+  {
+      // release the lock, finalize mm ops, and log the commit
+      cohort_ticket_release(&cohortticketlock, tx->numa_node);
+      OnCGLCommit(tx);
+  }
+
+  /**
+   *  Cohort read
+   */
+  void*
+  Cohort::read(STM_READ_SIG(,addr,))
+  {
+      return *addr;
+  }
+
+  /**
+   *  Cohort write
+   */
+  void
+  Cohort::write(STM_WRITE_SIG(,addr,val,mask))
+  {
+      STM_DO_MASKED_WRITE(addr, val, mask);
+  }
+
+  /**
+   *  Cohort unwinder:
+   *
+   *    As in MCS, aborts are never valid
+   */
+  stm::scope_t*
+  Cohort::rollback(STM_ROLLBACK_SIG(,,))
+  {
+      UNRECOVERABLE("ATTEMPTING TO ABORT AN IRREVOCABLE COHORT TRANSACTION");
+      return NULL;
+  }
+
+  /**
+   *  Cohort in-flight irrevocability:
+   *
+   *    Since we're already irrevocable, this code should never get called.
+   *    Instead, the become_irrevoc() call should just return true
+   */
+  bool
+  Cohort::irrevoc(TxThread*)
+  {
+      UNRECOVERABLE("COHORT::IRREVOC SHOULD NEVER BE CALLED");
+      return false;
+  }
+
+  /**
+   *  Switch to CohortCGL, CohortMCS or CohortTicket:
+   *
+   *    Each lock is released whenever no transaction is running, and no
+   *    other algorithm uses it, so no work is needed in this function
+   */
+  void
+  Cohort::onSwitchTo() {
+  }
+}
+
+namespace stm {
+  /**
+   *  CohortCGL initialization
+   */
+  template<>
+  void initTM<CohortCGL>()
+  {
+      // set the name
+      stms[CohortCGL].name      = "CohortCGL";
+
+      // set the pointers
+      stms[CohortCGL].begin     = ::CohortCGL::begin;
+      stms[CohortCGL].commit    = ::CohortCGL::commit;
+      stms[CohortCGL].read      = ::Cohort::read;
+      stms[CohortCGL].write     = ::Cohort::write;
+      stms[CohortCGL].rollback  = ::Cohort::rollback;
+      stms[CohortCGL].irrevoc   = ::Cohort::irrevoc;
+      stms[CohortCGL].switcher  = ::Cohort::onSwitchTo;
+      stms[CohortCGL].privatization_safe = true;
+  }
+
+  /**
+   *  CohortMCS initialization
+   */
+  template<>
+  void initTM<CohortMCS>()
+  {
+      // set the name
+      stms[CohortMCS].name      = "CohortMCS";
+
+      // set the pointers
+      stms[CohortMCS].begin     = ::CohortMCS::begin;
+      stms[CohortMCS].commit    = ::CohortMCS::commit;
+      stms[CohortMCS].read      = ::Cohort::read;
+      stms[CohortMCS].write     = ::Cohort::write;
+      stms[CohortMCS].rollback  = ::Cohort::rollback;
+      stms[CohortMCS].irrevoc   = ::Cohort::irrevoc;
+      stms[CohortMCS].switcher  = ::Cohort::onSwitchTo;
+      stms[CohortMCS].privatization_safe = true;
+  }
+
+  /**
+   *  CohortTicket initialization
+   */
+  template<>
+  void initTM<CohortTicket>()
+  {
+      // set the name
+      stms[CohortTicket].name      = "CohortTicket";
+
+      // set the pointers
+      stms[CohortTicket].begin     = ::CohortTicket::begin;
+      stms[CohortTicket].commit    = ::CohortTicket::commit;
+      stms[CohortTicket].read      = ::Cohort::read;
+      stms[CohortTicket].write     = ::Cohort::write;
+      stms[CohortTicket].rollback  = ::Cohort::rollback;
+      stms[CohortTicket].irrevoc   = ::Cohort::irrevoc;
+      stms[CohortTicket].switcher  = ::Cohort::onSwitchTo;
+      stms[CohortTicket].privatization_safe = true;
+  }
+}
@@ -376,6 +376,7 @@ namespace stm {
       stms[CTokenTurbo].commit    = ::CTokenTurbo::commit_ro;
       stms[CTokenTurbo].read      = ::CTokenTurbo::read_ro;
       stms[CTokenTurbo].write     = ::CTokenTurbo::write_ro;
+      stms[CTokenTurbo].read_turbo = ::CTokenTurbo::read_turbo;
       stms[CTokenTurbo].rollback  = ::CTokenTurbo::rollback;
       stms[CTokenTurbo].irrevoc   = ::CTokenTurbo::irrevoc;
       stms[CTokenTurbo].switcher  = ::CTokenTurbo::onSwitchTo;
@@ -17,6 +17,15 @@
  *    commit time.  Most importantly, there is no in-flight validation: if a
  *    timestamp is greater than when the transaction sampled the clock at begin
  *    time, the transaction aborts.
+ *
+ *    LLTExtend adds LSA-style snapshot extension (Riegel et al., DISC 2006):
+ *    when a read finds an orec that is newer than the start time, we
+ *    validate the read set, and if it is still valid we move the start time
+ *    up to the current clock and retry the read.  Extension costs a pass
+ *    over the read set, which is wasted if the read set turns out to be
+ *    invalid, so each thread keeps a credit that successful extensions raise
+ *    and failed ones lower.  A thread without credit aborts as LLT does, and
+ *    regains credit one abort at a time, so that it eventually tries again.
  */
 
 #include "../profiling.hpp"
@@ -32,6 +41,7 @@ using stm::UNRECOVERABLE;
 using stm::WriteSetEntry;
 using stm::orec_t;
 using stm::get_orec;
+using stm::id_version_t;
 
 
 /**
@@ -39,27 +49,104 @@ using stm::get_orec;
  *  circular dependencies.
  */
 namespace {
-  struct LLT
+  template <class EXT>
+  struct LLT_Generic
   {
       static TM_FASTCALL bool begin(TxThread*);
       static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
       static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_ronly(STM_READ_SIG(,,));
       static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void commit_ro(TxThread*);
       static TM_FASTCALL void commit_rw(TxThread*);
+      static TM_FASTCALL void commit_ronly(TxThread*);
 
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
       static bool irrevoc(TxThread*);
       static void onSwitchTo();
       static NOINLINE void validate(TxThread*);
+      static void Initialize(int id, const char* name);
+  };
+
+  /**
+   *  LLT never extends its start time
+   */
+  struct NoExtension
+  {
+      static bool extend(TxThread*) { return false; }
   };
 
+  /**
+   *  LLTExtend extends its start time while extensions keep succeeding
+   */
+  const int32_t EXTEND_CREDIT_MAX = 8;  // cap on earned credit
+  const int32_t EXTEND_PENALTY    = 4;  // credit lost on a failed extension
+
+  struct AdaptiveExtension
+  {
+      static NOINLINE bool extend(TxThread*);
+  };
+
+  /**
+   *  Try to extend the start time to the current clock.  Returns false
+   *  without validating if we have no credit, and false after validating if
+   *  the read set is no longer valid.
+   */
+  bool
+  AdaptiveExtension::extend(TxThread* tx)
+  {
+      if (tx->extend_credit <= 0) {
+          ++tx->extend_credit;
+          return false;
+      }
+
+      uintptr_t newts = timestamp.val;
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
+      // we hold no locks, so any orec newer than the start time is a conflict
+      foreach (OrecList, i, tx->r_orecs) {
+          if ((*i)->v.all > tx->start_time) {
+              tx->extend_credit -= EXTEND_PENALTY;
+              STM_PERF_LEAVE(tx);
+              return false;
+          }
+      }
+      STM_PERF_LEAVE(tx);
+
+      tx->start_time = newts;
+      if (tx->extend_credit < EXTEND_CREDIT_MAX)
+          ++tx->extend_credit;
+      return true;
+  }
+
+  template <class EXT>
+  void
+  LLT_Generic<EXT>::Initialize(int id, const char* name)
+  {
+      // set the name
+      stm::stms[id].name      = name;
+
+      // set the pointers
+      stm::stms[id].begin     = LLT_Generic<EXT>::begin;
+      stm::stms[id].commit    = LLT_Generic<EXT>::commit_ro;
+      stm::stms[id].read      = LLT_Generic<EXT>::read_ro;
+      stm::stms[id].write     = LLT_Generic<EXT>::write_ro;
+      stm::stms[id].read_ronly   = LLT_Generic<EXT>::read_ronly;
+      stm::stms[id].commit_ronly = LLT_Generic<EXT>::commit_ronly;
+      stm::stms[id].rollback  = LLT_Generic<EXT>::rollback;
+      stm::stms[id].irrevoc   = LLT_Generic<EXT>::irrevoc;
+      stm::stms[id].switcher  = LLT_Generic<EXT>::onSwitchTo;
+      stm::stms[id].privatization_safe = false;
+      stm::stms[id].counts_validations = true;
+  }
+
   /**
    *  LLT begin:
    */
+  template <class EXT>
   bool
-  LLT::begin(TxThread* tx)
+  LLT_Generic<EXT>::begin(TxThread* tx)
   {
       tx->allocator.onTxBegin();
       // get a start time
@@ -70,22 +157,37 @@ namespace {
   /**
    *  LLT commit (read-only):
    */
+  template <class EXT>
   void
-  LLT::commit_ro(TxThread* tx)
+  LLT_Generic<EXT>::commit_ro(TxThread* tx)
   {
       // read-only, so just reset lists
       tx->r_orecs.reset();
       OnReadOnlyCommit(tx);
   }
 
+  /**
+   *  LLT commit (declared read-only):
+   *
+   *    Every read was validated against the start time, and there is no
+   *    read log to reset
+   */
+  template <class EXT>
+  void
+  LLT_Generic<EXT>::commit_ronly(TxThread* tx)
+  {
+      OnReadOnlyCommit(tx);
+  }
+
   /**
    *  LLT commit (writing context):
    *
    *    Get all locks, validate, do writeback.  Use the counter to avoid some
    *    validations.
    */
+  template <class EXT>
   void
-  LLT::commit_rw(TxThread* tx)
+  LLT_Generic<EXT>::commit_rw(TxThread* tx)
   {
       // acquire locks
       foreach (WriteSet, i, tx->writes) {
@@ -133,10 +235,49 @@ namespace {
   /**
    *  LLT read (read-only transaction)
    *
-   *    We use "check twice" timestamps in LLT
+   *    We use "check twice" timestamps in LLT.  If the orec is unlocked but
+   *    too new, or changed while we read, we retry after extending the start
+   *    time, if the extension policy lets us.
    */
+  template <class EXT>
   void*
-  LLT::read_ro(STM_READ_SIG(tx,addr,))
+  LLT_Generic<EXT>::read_ro(STM_READ_SIG(tx,addr,))
+  {
+      // get the orec addr
+      orec_t* o = get_orec(addr);
+
+      while (true) {
+          // read orec, then val, then orec
+          uintptr_t ivt = o->v.all;
+          CFENCE;
+          void* tmp = *addr;
+          CFENCE;
+          id_version_t ivt2;
+          ivt2.all = o->v.all;
+          // if orec never changed, and isn't too new, the read is valid
+          if ((ivt <= tx->start_time) && (ivt == ivt2.all)) {
+              // log orec, return the value
+              tx->r_orecs.insert(o);
+              return tmp;
+          }
+          // no extension helps while the orec is locked
+          if (ivt2.fields.lock || !EXT::extend(tx))
+              tx->tmabort(tx);
+      }
+  }
+
+  /**
+   *  LLT read (declared read-only transaction)
+   *
+   *    Without a read log we cannot extend the start time, so a transaction
+   *    that cannot write never needs to revisit its reads: the per-read check
+   *    against the start time is all the validation it needs.  This holds in
+   *    LLTExtend too, which just does not extend declared read-only
+   *    transactions.
+   */
+  template <class EXT>
+  void*
+  LLT_Generic<EXT>::read_ronly(STM_READ_SIG(tx,addr,))
   {
       // get the orec addr
       orec_t* o = get_orec(addr);
@@ -148,21 +289,19 @@ namespace {
       CFENCE;
       uintptr_t ivt2 = o->v.all;
       // if orec never changed, and isn't too new, the read is valid
-      if ((ivt <= tx->start_time) && (ivt == ivt2)) {
-          // log orec, return the value
-          tx->r_orecs.insert(o);
+      if ((ivt <= tx->start_time) && (ivt == ivt2))
           return tmp;
-      }
-      // unreachable
       tx->tmabort(tx);
+      // unreachable
       return NULL;
   }
 
   /**
    *  LLT read (writing transaction)
    */
+  template <class EXT>
   void*
-  LLT::read_rw(STM_READ_SIG(tx,addr,mask))
+  LLT_Generic<EXT>::read_rw(STM_READ_SIG(tx,addr,mask))
   {
       // check the log for a RAW hazard, we expect to miss
       WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
@@ -172,31 +311,34 @@ namespace {
       // get the orec addr
       orec_t* o = get_orec(addr);
 
-      // read orec, then val, then orec
-      uintptr_t ivt = o->v.all;
-      CFENCE;
-      void* tmp = *addr;
-      CFENCE;
-      uintptr_t ivt2 = o->v.all;
-
-      // fixup is here to minimize the postvalidation orec read latency
-      REDO_RAW_CLEANUP(tmp, found, log, mask);
-      // if orec never changed, and isn't too new, the read is valid
-      if ((ivt <= tx->start_time) && (ivt == ivt2)) {
-          // log orec, return the value
-          tx->r_orecs.insert(o);
-          return tmp;
+      while (true) {
+          // read orec, then val, then orec
+          uintptr_t ivt = o->v.all;
+          CFENCE;
+          void* tmp = *addr;
+          CFENCE;
+          id_version_t ivt2;
+          ivt2.all = o->v.all;
+
+          // if orec never changed, and isn't too new, the read is valid
+          if ((ivt <= tx->start_time) && (ivt == ivt2.all)) {
+              REDO_RAW_CLEANUP(tmp, found, log, mask);
+              // log orec, return the value
+              tx->r_orecs.insert(o);
+              return tmp;
+          }
+          // no extension helps while the orec is locked
+          if (ivt2.fields.lock || !EXT::extend(tx))
+              tx->tmabort(tx);
       }
-      tx->tmabort(tx);
-      // unreachable
-      return NULL;
   }
 
   /**
    *  LLT write (read-only context)
    */
+  template <class EXT>
   void
-  LLT::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  LLT_Generic<EXT>::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
   {
       // add to redo log
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
@@ -206,8 +348,9 @@ namespace {
   /**
    *  LLT write (writing context)
    */
+  template <class EXT>
   void
-  LLT::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  LLT_Generic<EXT>::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
   {
       // add to redo log
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
@@ -216,8 +359,9 @@ namespace {
   /**
    *  LLT unwinder:
    */
+  template <class EXT>
   stm::scope_t*
-  LLT::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  LLT_Generic<EXT>::rollback(STM_ROLLBACK_SIG(tx, except, len))
   {
       PreRollback(tx);
 
@@ -240,8 +384,9 @@ namespace {
   /**
    *  LLT in-flight irrevocability:
    */
+  template <class EXT>
   bool
-  LLT::irrevoc(TxThread*)
+  LLT_Generic<EXT>::irrevoc(TxThread*)
   {
       return false;
   }
@@ -249,9 +394,12 @@ namespace {
   /**
    *  LLT validation
    */
+  template <class EXT>
   void
-  LLT::validate(TxThread* tx)
+  LLT_Generic<EXT>::validate(TxThread* tx)
   {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
       // validate
       foreach (OrecList, i, tx->r_orecs) {
           uintptr_t ivt = (*i)->v.all;
@@ -259,6 +407,7 @@ namespace {
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
               tx->tmabort(tx);
       }
+      STM_PERF_LEAVE(tx);
   }
 
   /**
@@ -268,31 +417,30 @@ namespace {
    *    timestamp as a zero-one mutex.  If they do, then they back up the
    *    timestamp first, in timestamp_max.
    */
+  template <class EXT>
   void
-  LLT::onSwitchTo()
+  LLT_Generic<EXT>::onSwitchTo()
   {
       timestamp.val = MAXIMUM(timestamp.val, timestamp_max.val);
   }
 }
 
-namespace stm {
-  /**
-   *  LLT initialization
-   */
-  template<>
-  void initTM<LLT>()
-  {
-      // set the name
-      stms[LLT].name      = "LLT";
+// -----------------------------------------------------------------------------
+// Register initialization as declaratively as possible.
+// -----------------------------------------------------------------------------
+#define FOREACH_LLT(MACRO)                      \
+    MACRO(LLT, NoExtension)                     \
+    MACRO(LLTExtend, AdaptiveExtension)
 
-      // set the pointers
-      stms[LLT].begin     = ::LLT::begin;
-      stms[LLT].commit    = ::LLT::commit_ro;
-      stms[LLT].read      = ::LLT::read_ro;
-      stms[LLT].write     = ::LLT::write_ro;
-      stms[LLT].rollback  = ::LLT::rollback;
-      stms[LLT].irrevoc   = ::LLT::irrevoc;
-      stms[LLT].switcher  = ::LLT::onSwitchTo;
-      stms[LLT].privatization_safe = false;
-  }
+#define INIT_LLT(ID, EXT)                       \
+    template <>                                 \
+    void initTM<ID>() {                         \
+        LLT_Generic<EXT>::Initialize(ID, #ID);  \
+    }
+
+namespace stm {
+  FOREACH_LLT(INIT_LLT)
 }
+
+#undef FOREACH_LLT
+#undef INIT_LLT
@@ -17,6 +17,7 @@
  *    strong as Asymmetric Lock Atomicity (ALA).
  */
 
+#include <cstring>
 #include "../cm.hpp"
 #include "algs.hpp"
 #include "RedoRAWUtils.hpp"
@@ -47,6 +48,8 @@ namespace {
       static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
       static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static void read_block(STM_READ_BLOCK_SIG(,,,));
+      static void write_block(STM_WRITE_BLOCK_SIG(,,,));
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
       static void initialize(int id, const char* name);
   };
@@ -54,6 +57,8 @@ namespace {
   uintptr_t
   validate(TxThread* tx)
   {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
       while (true) {
           // read the lock until it is even
           uintptr_t s = timestamp.val;
@@ -68,13 +73,17 @@ namespace {
           foreach (ValueList, i, tx->vlist)
               valid &= STM_LOG_VALUE_IS_VALID(i, tx);
 
-          if (!valid)
+          if (!valid) {
+              STM_PERF_LEAVE(tx);
               return VALIDATION_FAILED;
+          }
 
           // restart if timestamp changed during read set iteration
           CFENCE;
-          if (timestamp.val == s)
+          if (timestamp.val == s) {
+              STM_PERF_LEAVE(tx);
               return s;
+          }
       }
   }
 
@@ -118,9 +127,12 @@ namespace {
       stm::stms[id].commit    = NOrec_Generic<CM>::commit_ro;
       stm::stms[id].read      = NOrec_Generic<CM>::read_ro;
       stm::stms[id].write     = NOrec_Generic<CM>::write_ro;
+      stm::stms[id].read_block  = NOrec_Generic<CM>::read_block;
+      stm::stms[id].write_block = NOrec_Generic<CM>::write_block;
       stm::stms[id].irrevoc   = irrevoc;
       stm::stms[id].switcher  = onSwitchTo;
       stm::stms[id].privatization_safe = true;
+      stm::stms[id].counts_validations = true;
       stm::stms[id].rollback  = NOrec_Generic<CM>::rollback;
   }
 
@@ -279,6 +291,50 @@ namespace {
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
   }
 
+  /**
+   *  NOrec block read:
+   *
+   *    Copy the whole block during one period where the seqlock is even and
+   *    unchanged, then log the values.  Once there are buffered writes, each
+   *    word needs a RAW check, so we use the word barriers instead.
+   */
+  template <class CM>
+  void
+  NOrec_Generic<CM>::read_block(STM_READ_BLOCK_SIG(tx,to,addr,words))
+  {
+      if (tx->writes.size()) {
+          stm::read_block_fallback(tx, to, addr, words);
+          return;
+      }
+
+      memcpy(to, addr, words * sizeof(void*));
+      CFENCE;
+      while (tx->start_time != timestamp.val) {
+          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+              tx->tmabort(tx);
+          memcpy(to, addr, words * sizeof(void*));
+          CFENCE;
+      }
+
+      for (size_t i = 0; i < words; ++i)
+          STM_LOG_VALUE(tx, addr + i, to[i], ~0x0);
+  }
+
+  /**
+   *  NOrec block write:
+   *
+   *    Buffer every word, and switch to a writing context
+   */
+  template <class CM>
+  void
+  NOrec_Generic<CM>::write_block(STM_WRITE_BLOCK_SIG(tx,addr,from,words))
+  {
+      for (size_t i = 0; i < words; ++i)
+          tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr + i, from[i],
+                                                              ~0x0)));
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
   template <class CM>
   stm::scope_t*
   NOrec_Generic<CM>::rollback(STM_ROLLBACK_SIG(tx, except, len))
@@ -305,7 +361,8 @@ namespace {
     MACRO(NOrec, HyperAggressiveCM)             \
     MACRO(NOrecHour, HourglassCM)               \
     MACRO(NOrecBackoff, BackoffCM)              \
-    MACRO(NOrecHB, HourglassBackoffCM)
+    MACRO(NOrecHB, HourglassBackoffCM)          \
+    MACRO(NOrecShrink, ShrinkCM)
 
 #define INIT_NOREC(ID, CM)                      \
     template <>                                 \
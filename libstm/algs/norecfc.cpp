@@ -0,0 +1,348 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  NOrecFC Implementation
+ *
+ *    This is NOrec with a flat-combining commit.  Instead of each writer
+ *    acquiring the sequence lock, doing its own writeback, and releasing the
+ *    lock (which makes every in-flight transaction validate once per
+ *    writer), a writer publishes its request in a per-thread slot and then
+ *    tries to acquire the sequence lock.  Whoever gets the lock becomes the
+ *    combiner: it validates and writes back every pending request, in slot
+ *    order, and then releases the lock once.  Requests that commit together
+ *    cost readers one validation.
+ *
+ *    The combiner validates each request by value, against memory that
+ *    already includes the writes of earlier requests in the batch, so the
+ *    batch is equivalent to committing the requests one at a time in slot
+ *    order.  A request whose reads were overwritten is marked aborted, and
+ *    its owner aborts when it sees the mark.  Thus write sets that conflict
+ *    with an earlier member of the batch are not applied.
+ *
+ *    Requests' read and write logs are only touched by the combiner while
+ *    their owners spin on the slot, and owners only reset them once the slot
+ *    is no longer pending.
+ */
+
+#include "../profiling.hpp"
+#include "algs.hpp"
+#include "RedoRAWUtils.hpp"
+
+using stm::TxThread;
+using stm::timestamp;
+using stm::threadcount;
+using stm::threads;
+using stm::pad_word_t;
+using stm::WriteSetEntry;
+using stm::ValueList;
+using stm::ValueListEntry;
+
+
+/**
+ *  Declare the functions that we're going to implement, so that we can avoid
+ *  circular dependencies.
+ */
+namespace {
+  struct NOrecFC {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
+      static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void commit_ro(TxThread*);
+      static TM_FASTCALL void commit_rw(TxThread*);
+
+      static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool irrevoc(TxThread*);
+      static void onSwitchTo();
+
+      static const uintptr_t VALIDATION_FAILED = 1;
+      static NOINLINE uintptr_t validate(TxThread*);
+      static NOINLINE void combine(uintptr_t);
+  };
+
+  /*** states of a commit slot */
+  const uintptr_t FC_EMPTY     = 0;
+  const uintptr_t FC_PENDING   = 1;
+  const uintptr_t FC_COMMITTED = 2;
+  const uintptr_t FC_ABORTED   = 3;
+
+  /*** one commit request slot per thread */
+  pad_word_t fc_slots[stm::MAX_THREADS] = {{0}};
+
+  /**
+   *  NOrecFC begin:
+   *
+   *    Standard NOrec begin: round the sequence lock down to even
+   */
+  bool
+  NOrecFC::begin(TxThread* tx)
+  {
+      tx->start_time = timestamp.val & ~(1L);
+      tx->allocator.onTxBegin();
+      return false;
+  }
+
+  /**
+   *  NOrecFC commit (read-only):
+   *
+   *    Standard NOrec RO commit: the last read was consistent
+   */
+  void
+  NOrecFC::commit_ro(TxThread* tx)
+  {
+      tx->vlist.reset();
+      OnReadOnlyCommit(tx);
+  }
+
+  /**
+   *  NOrecFC combiner:
+   *
+   *    Called with the sequence lock held (it was 's', now s + 1).  Commit or
+   *    abort every pending request, then release the lock.
+   */
+  void
+  NOrecFC::combine(uintptr_t s)
+  {
+      for (uint32_t i = 0; i < threadcount.val; ++i) {
+          if (fc_slots[i].val != FC_PENDING)
+              continue;
+          TxThread* o = threads[i];
+          ++o->num_validations;
+          bool valid = true;
+          foreach (ValueList, v, o->vlist)
+              valid &= STM_LOG_VALUE_IS_VALID(v, o);
+          if (valid)
+              o->writes.writeback();
+          CFENCE;
+          fc_slots[i].val = valid ? FC_COMMITTED : FC_ABORTED;
+      }
+
+      // one release for the whole batch
+      CFENCE;
+      timestamp.val = s + 2;
+  }
+
+  /**
+   *  NOrecFC commit (writing context):
+   *
+   *    Publish the request, then either become the combiner or wait for one
+   *    to handle it.
+   */
+  void
+  NOrecFC::commit_rw(TxThread* tx)
+  {
+      pad_word_t& slot = fc_slots[tx->id - 1];
+      CFENCE;
+      slot.val = FC_PENDING;
+      WBR;
+
+      while (slot.val == FC_PENDING) {
+          uintptr_t s = timestamp.val;
+          if (!(s & 1) && bcasptr(&timestamp.val, s, s + 1))
+              combine(s);
+          else
+              spin64();
+      }
+
+      bool committed = (slot.val == FC_COMMITTED);
+      slot.val = FC_EMPTY;
+      if (!committed)
+          tx->tmabort(tx);
+
+      tx->vlist.reset();
+      tx->writes.reset();
+      OnReadWriteCommit(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  NOrecFC read (read-only transaction)
+   *
+   *    This is a standard NOrec read
+   */
+  void*
+  NOrecFC::read_ro(STM_READ_SIG(tx,addr,mask))
+  {
+      // read the location to a temp
+      void* tmp = *addr;
+      CFENCE;
+
+      while (tx->start_time != timestamp.val) {
+          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+              tx->tmabort(tx);
+          tmp = *addr;
+          CFENCE;
+      }
+
+      // log the address and value, uses the macro to deal with
+      // STM_PROTECT_STACK
+      STM_LOG_VALUE(tx, addr, tmp, mask);
+      return tmp;
+  }
+
+  /**
+   *  NOrecFC read (writing transaction)
+   *
+   *    Standard NOrec read from writing context
+   */
+  void*
+  NOrecFC::read_rw(STM_READ_SIG(tx,addr,mask))
+  {
+      // check the log for a RAW hazard, we expect to miss
+      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+      bool found = tx->writes.find(log);
+      REDO_RAW_CHECK(found, log, mask);
+
+      // reuse the read-only barrier for the bytes we did not find
+      void* val = read_ro(tx, addr STM_MASK(mask & ~log.mask));
+      REDO_RAW_CLEANUP(val, found, log, mask);
+      return val;
+  }
+
+  /**
+   *  NOrecFC write (read-only context)
+   *
+   *    log the write and switch to a writing context
+   */
+  void
+  NOrecFC::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
+  /**
+   *  NOrecFC write (writing context)
+   *
+   *    log the write
+   */
+  void
+  NOrecFC::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+  }
+
+  /**
+   *  NOrecFC unwinder:
+   *
+   *    A request that the combiner aborted has already left its slot, so
+   *    this is the standard NOrec rollback
+   */
+  stm::scope_t*
+  NOrecFC::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  {
+      PreRollback(tx);
+
+      // Perform writes to the exception object if there were any... taking the
+      // branch overhead without concern because we're not worried about
+      // rollback overheads.
+      STM_ROLLBACK(tx->writes, except, len);
+
+      tx->vlist.reset();
+      tx->writes.reset();
+      return PostRollback(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  NOrecFC in-flight irrevocability:
+   *
+   *    As in NOrec, we take the sequence lock and write back.  Pending
+   *    requests wait for the next combiner.
+   */
+  bool
+  NOrecFC::irrevoc(TxThread* tx)
+  {
+      while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
+          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+              return false;
+
+      tx->writes.writeback();
+
+      CFENCE;
+      timestamp.val = tx->start_time + 2;
+      tx->vlist.reset();
+      tx->writes.reset();
+      return true;
+  }
+
+  /**
+   *  NOrecFC validation
+   *
+   *    Make sure that during some time period where the seqlock is constant
+   *    and even, all values in the read log are still present in memory.
+   */
+  uintptr_t
+  NOrecFC::validate(TxThread* tx)
+  {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
+      while (true) {
+          // read the lock until it is even
+          uintptr_t s = timestamp.val;
+          if ((s & 1) == 1)
+              continue;
+
+          // check the read set
+          CFENCE;
+          bool valid = true;
+          foreach (ValueList, i, tx->vlist)
+              valid &= STM_LOG_VALUE_IS_VALID(i, tx);
+
+          if (!valid) {
+              STM_PERF_LEAVE(tx);
+              return VALIDATION_FAILED;
+          }
+
+          // restart if timestamp changed during read set iteration
+          CFENCE;
+          if (timestamp.val == s) {
+              STM_PERF_LEAVE(tx);
+              return s;
+          }
+      }
+  }
+
+  /**
+   *  Switch to NOrecFC:
+   *
+   *    Must be sure the timestamp is not odd.  No thread is in a
+   *    transaction, so no slot is pending.
+   */
+  void
+  NOrecFC::onSwitchTo()
+  {
+      if (timestamp.val & 1)
+          ++timestamp.val;
+  }
+}
+
+namespace stm {
+  /**
+   *  NOrecFC initialization
+   */
+  template<>
+  void initTM<NOrecFC>()
+  {
+      // set the name
+      stm::stms[NOrecFC].name      = "NOrecFC";
+
+      // set the pointers
+      stm::stms[NOrecFC].begin    = ::NOrecFC::begin;
+      stm::stms[NOrecFC].commit   = ::NOrecFC::commit_ro;
+      stm::stms[NOrecFC].read     = ::NOrecFC::read_ro;
+      stm::stms[NOrecFC].write    = ::NOrecFC::write_ro;
+      stm::stms[NOrecFC].rollback = ::NOrecFC::rollback;
+      stm::stms[NOrecFC].irrevoc  = ::NOrecFC::irrevoc;
+      stm::stms[NOrecFC].switcher = ::NOrecFC::onSwitchTo;
+      stm::stms[NOrecFC].privatization_safe = true;
+      stm::stms[NOrecFC].counts_validations = true;
+  }
+}
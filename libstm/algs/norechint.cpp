@@ -0,0 +1,358 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  NOrecHint Implementation
+ *
+ *    This is NOrec with region versions as validation hints.  Writers still
+ *    commit under the sequence lock, but before writing back they stamp the
+ *    region (see OrecLazyRegion) of each location they write with the value
+ *    that will release the lock.  A region whose version is no newer than our
+ *    start time cannot have been written since our reads were last valid.
+ *
+ *    Readers log values as in NOrec, and also remember the first
+ *    HINT_REGIONS regions they read from.  When the sequence lock moves, a
+ *    transaction whose regions all are unchanged is still valid, without
+ *    looking at its values; this avoids NOrec's quadratic revalidation when
+ *    many writers commit to unrelated data.  Otherwise, we only check the
+ *    values of logged locations whose regions changed.
+ *
+ *    Validation still happens during a period when the sequence lock is even
+ *    and unchanged, so NOrecHint is privatization safe, as NOrec is.
+ */
+
+#include "../profiling.hpp"
+#include "algs.hpp"
+#include "RedoRAWUtils.hpp"
+
+using stm::TxThread;
+using stm::timestamp;
+using stm::WriteSet;
+using stm::WriteSetEntry;
+using stm::ValueList;
+using stm::ValueListEntry;
+using stm::RegionReadList;
+using stm::region_read_t;
+using stm::regions;
+using stm::get_orec;
+using stm::get_region_index;
+using stm::NUM_REGIONS;
+
+
+/**
+ *  Declare the functions that we're going to implement, so that we can avoid
+ *  circular dependencies.
+ */
+namespace {
+  struct NOrecHint {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
+      static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void commit_ro(TxThread*);
+      static TM_FASTCALL void commit_rw(TxThread*);
+
+      static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool irrevoc(TxThread*);
+      static void onSwitchTo();
+
+      static const uintptr_t VALIDATION_FAILED = 1;
+      static NOINLINE uintptr_t validate(TxThread*);
+  };
+
+  /**
+   *  The number of regions a transaction remembers.  Once it reads from one
+   *  more, we append an entry for NUM_REGIONS, which marks the hints as
+   *  incomplete.
+   */
+  const uint32_t HINT_REGIONS = 8;
+
+  /*** the region of an address */
+  TM_INLINE
+  inline uint32_t region_of(void* addr)
+  {
+      return get_region_index(get_orec(addr));
+  }
+
+  /**
+   *  Remember the region of a read, until we have too many.  Consecutive
+   *  reads usually hit the same region, so we check the last one first.
+   */
+  TM_INLINE
+  inline void log_region(TxThread* tx, void* addr)
+  {
+      unsigned long n = tx->r_regions.size();
+      if (n > HINT_REGIONS)
+          return;
+      uint32_t r = region_of(addr);
+      if (n && ((tx->r_regions.end() - 1)->region == r))
+          return;
+      foreach (RegionReadList, i, tx->r_regions)
+          if (i->region == r)
+              return;
+      if (n == HINT_REGIONS)
+          r = NUM_REGIONS;
+      tx->r_regions.insert(region_read_t(r, 0));
+  }
+
+  /*** stamp the regions of our writes; we must hold the sequence lock */
+  TM_INLINE
+  inline void stamp_regions(TxThread* tx, uintptr_t end_time)
+  {
+      foreach (WriteSet, i, tx->writes)
+          regions[region_of(i->addr)].v = end_time;
+  }
+
+  /**
+   *  NOrecHint begin:
+   *
+   *    Standard NOrec begin: round the sequence lock down to even
+   */
+  bool
+  NOrecHint::begin(TxThread* tx)
+  {
+      tx->start_time = timestamp.val & ~(1L);
+      tx->allocator.onTxBegin();
+      return false;
+  }
+
+  /**
+   *  NOrecHint commit (read-only):
+   *
+   *    Standard NOrec RO commit: the last read was consistent
+   */
+  void
+  NOrecHint::commit_ro(TxThread* tx)
+  {
+      tx->vlist.reset();
+      tx->r_regions.reset();
+      OnReadOnlyCommit(tx);
+  }
+
+  /**
+   *  NOrecHint commit (writing context):
+   *
+   *    NOrec commit, but we stamp our regions before writing back
+   */
+  void
+  NOrecHint::commit_rw(TxThread* tx)
+  {
+      // get the lock and validate (use RingSTM obstruction-free technique)
+      while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
+          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+              tx->tmabort(tx);
+
+      stamp_regions(tx, tx->start_time + 2);
+      tx->writes.writeback();
+
+      // Release the sequence lock, then clean up
+      CFENCE;
+      timestamp.val = tx->start_time + 2;
+      tx->vlist.reset();
+      tx->r_regions.reset();
+      tx->writes.reset();
+      OnReadWriteCommit(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  NOrecHint read (read-only transaction)
+   *
+   *    This is a standard NOrec read, which also logs the region
+   */
+  void*
+  NOrecHint::read_ro(STM_READ_SIG(tx,addr,mask))
+  {
+      // read the location to a temp
+      void* tmp = *addr;
+      CFENCE;
+
+      while (tx->start_time != timestamp.val) {
+          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+              tx->tmabort(tx);
+          tmp = *addr;
+          CFENCE;
+      }
+
+      // log the address and value, uses the macro to deal with
+      // STM_PROTECT_STACK
+      STM_LOG_VALUE(tx, addr, tmp, mask);
+      log_region(tx, addr);
+      return tmp;
+  }
+
+  /**
+   *  NOrecHint read (writing transaction)
+   *
+   *    Standard NOrec read from writing context
+   */
+  void*
+  NOrecHint::read_rw(STM_READ_SIG(tx,addr,mask))
+  {
+      // check the log for a RAW hazard, we expect to miss
+      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+      bool found = tx->writes.find(log);
+      REDO_RAW_CHECK(found, log, mask);
+
+      // reuse the read-only barrier for the bytes we did not find
+      void* val = read_ro(tx, addr STM_MASK(mask & ~log.mask));
+      REDO_RAW_CLEANUP(val, found, log, mask);
+      return val;
+  }
+
+  /**
+   *  NOrecHint write (read-only context)
+   *
+   *    log the write and switch to a writing context
+   */
+  void
+  NOrecHint::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
+  /**
+   *  NOrecHint write (writing context)
+   *
+   *    log the write
+   */
+  void
+  NOrecHint::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+  }
+
+  /**
+   *  NOrecHint unwinder:
+   */
+  stm::scope_t*
+  NOrecHint::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  {
+      PreRollback(tx);
+
+      // Perform writes to the exception object if there were any... taking the
+      // branch overhead without concern because we're not worried about
+      // rollback overheads.
+      STM_ROLLBACK(tx->writes, except, len);
+
+      tx->vlist.reset();
+      tx->r_regions.reset();
+      tx->writes.reset();
+      return PostRollback(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  NOrecHint in-flight irrevocability:
+   *
+   *    As in NOrec, we take the sequence lock and write back
+   */
+  bool
+  NOrecHint::irrevoc(TxThread* tx)
+  {
+      while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
+          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+              return false;
+
+      stamp_regions(tx, tx->start_time + 2);
+      tx->writes.writeback();
+
+      CFENCE;
+      timestamp.val = tx->start_time + 2;
+      tx->vlist.reset();
+      tx->r_regions.reset();
+      tx->writes.reset();
+      return true;
+  }
+
+  /**
+   *  NOrecHint validation
+   *
+   *    Make sure that during some time period where the seqlock is constant
+   *    and even, all values in the read log are still present in memory.  If
+   *    none of our regions changed since start_time, that is already known.
+   *    Otherwise we skip the values whose regions did not change.
+   */
+  uintptr_t
+  NOrecHint::validate(TxThread* tx)
+  {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
+      while (true) {
+          // read the lock until it is even
+          uintptr_t s = timestamp.val;
+          if ((s & 1) == 1)
+              continue;
+
+          // check the hints; the NUM_REGIONS marker counts as changed
+          CFENCE;
+          bool changed = false;
+          foreach (RegionReadList, i, tx->r_regions)
+              changed |= (i->region == NUM_REGIONS) ||
+                         (regions[i->region].v > tx->start_time);
+
+          // check the read set, where its regions changed
+          bool valid = true;
+          if (changed) {
+              foreach (ValueList, i, tx->vlist)
+                  if (regions[region_of(i->getAddr())].v > tx->start_time)
+                      valid &= STM_LOG_VALUE_IS_VALID(i, tx);
+          }
+
+          if (!valid) {
+              STM_PERF_LEAVE(tx);
+              return VALIDATION_FAILED;
+          }
+
+          // restart if timestamp changed during read set iteration
+          CFENCE;
+          if (timestamp.val == s) {
+              STM_PERF_LEAVE(tx);
+              return s;
+          }
+      }
+  }
+
+  /**
+   *  Switch to NOrecHint:
+   *
+   *    Must be sure the timestamp is not odd.  Region versions left by other
+   *    algorithms can only make us check values we did not need to.
+   */
+  void
+  NOrecHint::onSwitchTo()
+  {
+      if (timestamp.val & 1)
+          ++timestamp.val;
+  }
+}
+
+namespace stm {
+  /**
+   *  NOrecHint initialization
+   */
+  template<>
+  void initTM<NOrecHint>()
+  {
+      // set the name
+      stm::stms[NOrecHint].name      = "NOrecHint";
+
+      // set the pointers
+      stm::stms[NOrecHint].begin    = ::NOrecHint::begin;
+      stm::stms[NOrecHint].commit   = ::NOrecHint::commit_ro;
+      stm::stms[NOrecHint].read     = ::NOrecHint::read_ro;
+      stm::stms[NOrecHint].write    = ::NOrecHint::write_ro;
+      stm::stms[NOrecHint].rollback = ::NOrecHint::rollback;
+      stm::stms[NOrecHint].irrevoc  = ::NOrecHint::irrevoc;
+      stm::stms[NOrecHint].switcher = ::NOrecHint::onSwitchTo;
+      stm::stms[NOrecHint].privatization_safe = true;
+      stm::stms[NOrecHint].counts_validations = true;
+  }
+}
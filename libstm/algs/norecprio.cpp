@@ -260,6 +260,7 @@ namespace {
   uintptr_t
   NOrecPrio::validate(TxThread* tx)
   {
+      ++tx->num_validations;
       while (true) {
           // read the lock until it is even
           uintptr_t s = timestamp.val;
@@ -316,5 +317,6 @@ namespace stm {
       stm::stms[NOrecPrio].irrevoc  = ::NOrecPrio::irrevoc;
       stm::stms[NOrecPrio].switcher = ::NOrecPrio::onSwitchTo;
       stm::stms[NOrecPrio].privatization_safe = true;
+      stm::stms[NOrecPrio].counts_validations = true;
   }
 }
@@ -76,6 +76,7 @@ namespace {
       stm::stms[id].irrevoc   = OrEAU_Generic<CM>::irrevoc;
       stm::stms[id].switcher  = OrEAU_Generic<CM>::onSwitchTo;
       stm::stms[id].privatization_safe = false;
+      stm::stms[id].counts_validations = true;
   }
 
   /**
@@ -399,6 +400,7 @@ namespace {
   void
   OrEAU_Generic<CM>::validate(TxThread* tx)
   {
+      ++tx->num_validations;
       foreach (OrecList, i, tx->r_orecs) {
           // read this orec
           uintptr_t ivt = (*i)->v.all;
@@ -429,7 +431,10 @@ namespace {
     MACRO(OrEAUBackoff, BackoffCM)                     \
     MACRO(OrEAUFCM, FCM)                        \
     MACRO(OrEAUNoBackoff, HyperAggressiveCM)           \
-    MACRO(OrEAUHour, HourglassCM)
+    MACRO(OrEAUHour, HourglassCM)               \
+    MACRO(OrEAUKarma, KarmaCM)                  \
+    MACRO(OrEAUPolka, PolkaCM)                  \
+    MACRO(OrEAUGreedy, GreedyCM)
 
 #define INIT_OREAU(ID, CM)                      \
     template <>                                 \
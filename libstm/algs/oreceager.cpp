@@ -39,10 +39,22 @@
  *    max value written.  If the value is greater than the timestamp, then at
  *    the end of the abort code, we increment the timestamp.  A few simple
  *    invariants about time ensure correctness.
+ *
+ *    OrecEager supports concurrent inevitability.  A single transaction at a
+ *    time (the holder of inev_token) can become inevitable by locking the
+ *    orecs of everything it has read.  From then on it locks every orec it
+ *    touches, waiting rather than aborting when an orec is held by someone
+ *    else, and writes in place without undo logging.  Since nobody ever
+ *    waits for a lock, this cannot deadlock, and other transactions keep
+ *    running, aborting only if they touch an orec that the inevitable
+ *    transaction holds.
  */
 
+#include <cstring>
 #include "../profiling.hpp"
 #include "../cm.hpp"
+#include "../inst.hpp"
+#include "../policies/policies.hpp"
 #include "algs.hpp"
 
 using stm::TxThread;
@@ -52,6 +64,8 @@ using stm::orec_t;
 using stm::get_orec;
 using stm::id_version_t;
 using stm::UndoLogEntry;
+using stm::inev_token;
+using stm::UNRECOVERABLE;
 
 
 /**
@@ -59,8 +73,9 @@ using stm::UndoLogEntry;
  *  circular dependencies.
  *
  *  NB: OrecEager actually does better without fine-grained switching for
- *      read-only transactions, so we don't support the read-only optimization
- *      in this code.
+ *      read-only transactions, so we don't switch barriers on the first
+ *      write.  Transactions declared read-only via TM_BEGIN(readonly) do get
+ *      their own barriers, which know that the transaction holds no locks.
  */
 namespace {
   template <class CM>
@@ -68,12 +83,27 @@ namespace {
   {
       static TM_FASTCALL bool begin(TxThread*);
       static TM_FASTCALL void commit(TxThread*);
+      static TM_FASTCALL void commit_ronly(TxThread*);
       static void initialize(int id, const char* name);
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool become_inev(TxThread*);
+      static TM_FASTCALL void commit_inev(TxThread*);
   };
 
   TM_FASTCALL void* read(STM_READ_SIG(,,));
+  TM_FASTCALL void* read_ronly(STM_READ_SIG(,,));
   TM_FASTCALL void write(STM_WRITE_SIG(,,,));
+  TM_FASTCALL void* read_obj(STM_READ_OBJ_SIG(,,));
+  TM_FASTCALL void write_obj(STM_WRITE_OBJ_SIG(,,,));
+  void read_block(STM_READ_BLOCK_SIG(,,,));
+  void write_block(STM_WRITE_BLOCK_SIG(,,,));
+  TM_FASTCALL void* read_inev(STM_READ_SIG(,,));
+  TM_FASTCALL void write_inev(STM_WRITE_SIG(,,,));
+  TM_FASTCALL void* read_obj_inev(STM_READ_OBJ_SIG(,,));
+  TM_FASTCALL void write_obj_inev(STM_WRITE_OBJ_SIG(,,,));
+  void read_block_inev(STM_READ_BLOCK_SIG(,,,));
+  void write_block_inev(STM_WRITE_BLOCK_SIG(,,,));
+  NORETURN void abort_inev(TxThread*);
   bool irrevoc(TxThread*);
   NOINLINE void validate(TxThread*);
   void onSwitchTo();
@@ -95,9 +125,17 @@ namespace {
 
       stm::stms[id].read      = read;
       stm::stms[id].write     = write;
+      stm::stms[id].read_obj  = read_obj;
+      stm::stms[id].write_obj = write_obj;
+      stm::stms[id].read_block  = read_block;
+      stm::stms[id].write_block = write_block;
+      stm::stms[id].read_ronly   = read_ronly;
+      stm::stms[id].commit_ronly = OrecEager_Generic<CM>::commit_ronly;
       stm::stms[id].irrevoc   = irrevoc;
+      stm::stms[id].become_inev = OrecEager_Generic<CM>::become_inev;
       stm::stms[id].switcher  = onSwitchTo;
       stm::stms[id].privatization_safe = false;
+      stm::stms[id].counts_validations = true;
   }
 
   template <class CM>
@@ -159,16 +197,31 @@ namespace {
       OnReadWriteCommit(tx);
   }
 
+  /**
+   *  OrecEager commit (declared read-only):
+   *
+   *    A declared read-only transaction never locks anything, so there is
+   *    nothing to check
+   */
+  template <class CM>
+  void
+  OrecEager_Generic<CM>::commit_ronly(TxThread* tx)
+  {
+      CM::onCommit(tx);
+      tx->r_orecs.reset();
+      OnReadOnlyCommit(tx);
+  }
+
   /**
    *  OrecEager read:
    *
-   *    Must check orec twice, and may need to validate
+   *    Must check orec twice, and may need to validate.  The orec is passed
+   *    in, so that the same code serves tvar<T> objects, which embed their
+   *    own orec.
    */
-  void*
-  read(STM_READ_SIG(tx,addr,))
+  TM_INLINE
+  inline void* read_orec(TxThread* tx, orec_t* o, void** addr)
   {
-      // get the orec addr, then start loop to read a consistent value
-      orec_t* o = get_orec(addr);
       while (true) {
           // read the orec BEFORE we read anything else
           id_version_t ivt;
@@ -203,16 +256,67 @@ namespace {
       }
   }
 
+  /*** OrecEager read of a word, via the global orec table */
+  void*
+  read(STM_READ_SIG(tx,addr,))
+  {
+      return read_orec(tx, get_orec(addr), addr);
+  }
+
   /**
-   *  OrecEager write:
+   *  OrecEager read (declared read-only):
    *
-   *    Lock the orec, log the old value, do the write
+   *    As read_orec, but a declared read-only transaction never holds a lock,
+   *    so we skip the check for one of our own
    */
-  void
-  write(STM_WRITE_SIG(tx,addr,val,mask))
+  void*
+  read_ronly(STM_READ_SIG(tx,addr,))
   {
-      // get the orec addr, then enter loop to get lock from a consistent state
       orec_t* o = get_orec(addr);
+      while (true) {
+          // read the orec BEFORE we read anything else
+          id_version_t ivt;
+          ivt.all = o->v.all;
+          CFENCE;
+
+          // read the location, then re-read the orec
+          void* tmp = *addr;
+          CFENCE;
+          uintptr_t ivt2 = o->v.all;
+
+          // common case: new read to an unlocked, old location
+          if ((ivt.all == ivt2) && (ivt.all <= tx->start_time)) {
+              tx->r_orecs.insert(o);
+              return tmp;
+          }
+
+          // abort if locked
+          if (__builtin_expect(ivt.fields.lock, 0))
+              tx->tmabort(tx);
+
+          // scale timestamp if ivt is too new, then try again
+          uintptr_t newts = timestamp.val;
+          validate(tx);
+          tx->start_time = newts;
+      }
+  }
+
+  /*** OrecEager read of a tvar<T>, via its embedded orec */
+  void*
+  read_obj(STM_READ_OBJ_SIG(tx,o,addr))
+  {
+      return read_orec(tx, o, addr);
+  }
+
+  /**
+   *  OrecEager lock acquisition:
+   *
+   *    Lock the orec from a consistent state, or abort.  Returns once the
+   *    caller owns the orec.
+   */
+  TM_INLINE
+  inline void acquire_orec(TxThread* tx, orec_t* o)
+  {
       while (true) {
           // read the orec version number
           id_version_t ivt;
@@ -223,22 +327,15 @@ namespace {
               if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
                   tx->tmabort(tx);
 
-              // save old value, log lock, do the write, and return
+              // save old value, log lock, and return
               o->p = ivt.all;
               tx->locks.insert(o);
-              tx->undo_log.insert(UndoLogEntry(STM_UNDO_LOG_ENTRY(addr, *addr, mask)));
-              STM_DO_MASKED_WRITE(addr, val, mask);
               return;
           }
 
-          // next best: I already have the lock... must log old value, because
-          // many locations hash to the same orec.  The lock does not mean I
-          // have undo logged *this* location
-          if (ivt.all == tx->my_lock.all) {
-              tx->undo_log.insert(UndoLogEntry(STM_UNDO_LOG_ENTRY(addr, *addr, mask)));
-              STM_DO_MASKED_WRITE(addr, val, mask);
+          // next best: I already have the lock
+          if (ivt.all == tx->my_lock.all)
               return;
-          }
 
           // fail if lock held by someone else
           if (ivt.fields.lock)
@@ -251,6 +348,110 @@ namespace {
       }
   }
 
+  /**
+   *  OrecEager write:
+   *
+   *    Lock the orec, log the old value, do the write.  Note that we must log
+   *    the old value even if we already held the lock, because many locations
+   *    hash to the same orec.  The lock does not mean I have undo logged
+   *    *this* location.
+   */
+  TM_INLINE
+  inline void write_orec(orec_t* o, STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      acquire_orec(tx, o);
+      tx->undo_log.insert(UndoLogEntry(STM_UNDO_LOG_ENTRY(addr, *addr, mask)));
+      STM_DO_MASKED_WRITE(addr, val, mask);
+  }
+
+  /*** OrecEager write of a word, via the global orec table */
+  void
+  write(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      write_orec(get_orec(addr), tx, addr, val STM_MASK(mask));
+  }
+
+  /*** OrecEager write of a tvar<T>, via its embedded orec */
+  void
+  write_obj(STM_WRITE_OBJ_SIG(tx,o,addr,val))
+  {
+      write_orec(o, tx, addr, val STM_MASK(~0x0));
+  }
+
+  /**
+   *  OrecEager block read:
+   *
+   *    Split the block into runs of words that share an orec, and read each
+   *    run with a single pair of orec checks around a bulk copy.
+   */
+  void
+  read_block(STM_READ_BLOCK_SIG(tx,to,addr,words))
+  {
+      size_t i = 0;
+      while (i < words) {
+          // find the run of words covered by this orec
+          orec_t* o = get_orec(addr + i);
+          size_t j = i + 1;
+          while ((j < words) && (get_orec(addr + j) == o))
+              ++j;
+
+          while (true) {
+              // read the orec BEFORE we read anything else
+              id_version_t ivt;
+              ivt.all = o->v.all;
+              CFENCE;
+
+              // read the run
+              memcpy(to + i, addr + i, (j - i) * sizeof(void*));
+
+              // best case: I locked it already
+              if (ivt.all == tx->my_lock.all)
+                  break;
+
+              // re-read orec AFTER reading the run
+              CFENCE;
+              uintptr_t ivt2 = o->v.all;
+
+              // common case: unlocked, old run
+              if ((ivt.all == ivt2) && (ivt.all <= tx->start_time)) {
+                  tx->r_orecs.insert(o);
+                  break;
+              }
+
+              // abort if locked
+              if (__builtin_expect(ivt.fields.lock, 0))
+                  tx->tmabort(tx);
+
+              // scale timestamp if ivt is too new, then try again
+              uintptr_t newts = timestamp.val;
+              validate(tx);
+              tx->start_time = newts;
+          }
+          i = j;
+      }
+  }
+
+  /**
+   *  OrecEager block write:
+   *
+   *    Acquire each distinct orec once, undo log every word, and then do
+   *    the whole update with one bulk copy.
+   */
+  void
+  write_block(STM_WRITE_BLOCK_SIG(tx,addr,from,words))
+  {
+      orec_t* prev = NULL;
+      for (size_t i = 0; i < words; ++i) {
+          orec_t* o = get_orec(addr + i);
+          if (o != prev)
+              acquire_orec(tx, o);
+          prev = o;
+          tx->undo_log.insert(UndoLogEntry(STM_UNDO_LOG_ENTRY(addr + i, addr[i],
+                                                              ~0x0)));
+      }
+      memcpy(addr, from, words * sizeof(void*));
+  }
+
   /**
    *  OrecEager rollback:
    *
@@ -286,6 +487,16 @@ namespace {
       tx->undo_log.reset();
       tx->locks.reset();
 
+      // if we hold the inevitability token, our orecs are free now, so go
+      // back to the normal barriers and give the token up
+      if (inev_token.val == tx->id) {
+          tx->irrevocable = false;
+          tx->tmabort = TxThread::abort_handler;
+          stm::install_algorithm_local(stm::curr_policy.ALG_ID, tx);
+          CFENCE;
+          inev_token.val = 0;
+      }
+
       // notify CM
       CM::onAbort(tx);
 
@@ -293,6 +504,195 @@ namespace {
       return PostRollback(tx);
   }
 
+  /**
+   *  OrecEager inevitable lock acquisition:
+   *
+   *    Lock the orec no matter how new it is.  If someone else holds it, wait
+   *    for them to commit or abort.
+   */
+  TM_INLINE
+  inline void acquire_inev(TxThread* tx, orec_t* o)
+  {
+      while (true) {
+          id_version_t ivt;
+          ivt.all = o->v.all;
+          if (ivt.all == tx->my_lock.all)
+              return;
+          if (ivt.fields.lock) {
+              spin64();
+              continue;
+          }
+          if (bcasptr(&o->v.all, ivt.all, tx->my_lock.all)) {
+              o->p = ivt.all;
+              tx->locks.insert(o);
+              return;
+          }
+      }
+  }
+
+  /**
+   *  OrecEager inevitable read:
+   *
+   *    Reads lock their orec too, so that nobody can change what we've read
+   *    before we commit
+   */
+  void*
+  read_inev(STM_READ_SIG(tx,addr,))
+  {
+      acquire_inev(tx, get_orec(addr));
+      return *addr;
+  }
+
+  /**
+   *  OrecEager inevitable write:
+   *
+   *    We can't abort, so there is no need for undo logging
+   */
+  void
+  write_inev(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      acquire_inev(tx, get_orec(addr));
+      STM_DO_MASKED_WRITE(addr, val, mask);
+  }
+
+  /*** OrecEager inevitable read of a tvar<T>, via its embedded orec */
+  void*
+  read_obj_inev(STM_READ_OBJ_SIG(tx,o,addr))
+  {
+      acquire_inev(tx, o);
+      return *addr;
+  }
+
+  /*** OrecEager inevitable write of a tvar<T>, via its embedded orec */
+  void
+  write_obj_inev(STM_WRITE_OBJ_SIG(tx,o,addr,val))
+  {
+      acquire_inev(tx, o);
+      *addr = val;
+  }
+
+  /**
+   *  OrecEager inevitable block read:
+   *
+   *    Lock each distinct orec once, then do a single bulk copy
+   */
+  void
+  read_block_inev(STM_READ_BLOCK_SIG(tx,to,addr,words))
+  {
+      orec_t* prev = NULL;
+      for (size_t i = 0; i < words; ++i) {
+          orec_t* o = get_orec(addr + i);
+          if (o != prev)
+              acquire_inev(tx, o);
+          prev = o;
+      }
+      memcpy(to, addr, words * sizeof(void*));
+  }
+
+  /*** OrecEager inevitable block write: as above, without undo logging */
+  void
+  write_block_inev(STM_WRITE_BLOCK_SIG(tx,addr,from,words))
+  {
+      orec_t* prev = NULL;
+      for (size_t i = 0; i < words; ++i) {
+          orec_t* o = get_orec(addr + i);
+          if (o != prev)
+              acquire_inev(tx, o);
+          prev = o;
+      }
+      memcpy(addr, from, words * sizeof(void*));
+  }
+
+  /**
+   *  OrecEager inevitable abort:
+   *
+   *    The inevitable barriers write in place without undo logging, so an
+   *    inevitable transaction must never abort.  Trap any attempt.
+   */
+  void
+  abort_inev(TxThread*)
+  {
+      UNRECOVERABLE("Inevitable transaction attempted to abort.");
+  }
+
+  /**
+   *  OrecEager concurrent inevitability:
+   *
+   *    Claim the inevitability token, then lock every orec we've read.  If
+   *    any of them has changed since we read it, give up, so that the caller
+   *    can abort.  The rollback will release any orecs we locked here.
+   */
+  template <class CM>
+  bool
+  OrecEager_Generic<CM>::become_inev(TxThread* tx)
+  {
+      // If we hold no locks, the inevitable transaction can't be waiting on
+      // us, so it's safe to wait for it to finish.  Otherwise we must not
+      // wait.
+      if (!tx->locks.size())
+          while (inev_token.val)
+              spin64();
+      if (!bcasptr(&inev_token.val, (uintptr_t)0, (uintptr_t)tx->id))
+          return false;
+
+      // lock the read set
+      foreach (OrecList, i, tx->r_orecs) {
+          uintptr_t ivt = (*i)->v.all;
+          if (ivt == tx->my_lock.all)
+              continue;
+          if ((ivt > tx->start_time) ||
+              !bcasptr(&(*i)->v.all, ivt, tx->my_lock.all))
+          {
+              CFENCE;
+              inev_token.val = 0;
+              return false;
+          }
+          (*i)->p = ivt;
+          tx->locks.insert(*i);
+      }
+
+      // switch to the inevitable barriers.  tvar<T> accesses must lock the
+      // embedded orec, since that is what the normal tvar barriers check
+      tx->irrevocable   = true;
+      tx->tmread        = read_inev;
+      tx->tmwrite       = write_inev;
+      tx->tmcommit      = commit_inev;
+      tx->tmread_obj    = read_obj_inev;
+      tx->tmwrite_obj   = write_obj_inev;
+      tx->tmread_block  = read_block_inev;
+      tx->tmwrite_block = write_block_inev;
+      tx->tmabort       = abort_inev;
+      return true;
+  }
+
+  /**
+   *  OrecEager inevitable commit:
+   *
+   *    No validation is needed.  Release the locks at a new timestamp, then
+   *    restore the normal barriers and abort handler, and release the
+   *    inevitability token.
+   */
+  template <class CM>
+  void
+  OrecEager_Generic<CM>::commit_inev(TxThread* tx)
+  {
+      uintptr_t end_time = 1 + faiptr(&timestamp.val);
+      foreach (OrecList, i, tx->locks)
+          (*i)->v.all = end_time;
+
+      CM::onCommit(tx);
+      tx->locks.reset();
+      tx->undo_log.reset();
+      tx->r_orecs.reset();
+
+      tx->irrevocable = false;
+      tx->tmabort = TxThread::abort_handler;
+      stm::install_algorithm_local(stm::curr_policy.ALG_ID, tx);
+      CFENCE;
+      inev_token.val = 0;
+      OnReadWriteCommit(tx);
+  }
+
   /**
    *  OrecEager in-flight irrevocability:
    *
@@ -343,6 +743,8 @@ namespace {
   void
   validate(TxThread* tx)
   {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
       foreach (OrecList, i, tx->r_orecs) {
           // read this orec
           uintptr_t ivt = (*i)->v.all;
@@ -350,6 +752,7 @@ namespace {
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
               tx->tmabort(tx);
       }
+      STM_PERF_LEAVE(tx);
   }
 
   /**
@@ -331,6 +331,7 @@ namespace {
   void
   OrecEagerRedo::validate(TxThread* tx)
   {
+      ++tx->num_validations;
       foreach (OrecList, i, tx->r_orecs) {
           // read this orec
           uintptr_t ivt = (*i)->v.all;
@@ -373,5 +374,6 @@ namespace stm {
       stms[OrecEagerRedo].irrevoc   = ::OrecEagerRedo::irrevoc;
       stms[OrecEagerRedo].switcher  = ::OrecEagerRedo::onSwitchTo;
       stms[OrecEagerRedo].privatization_safe = false;
+      stms[OrecEagerRedo].counts_validations = true;
   }
 }
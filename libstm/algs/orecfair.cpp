@@ -494,6 +494,7 @@ namespace
   void
   OrecFair::validate(TxThread* tx)
   {
+      ++tx->num_validations;
       OrecList::iterator i = tx->r_orecs.begin(), e = tx->r_orecs.end();
       while (i != e) {
           // read this orec
@@ -599,5 +600,6 @@ namespace stm {
       stm::stms[OrecFair].irrevoc   = ::OrecFair::irrevoc;
       stm::stms[OrecFair].switcher  = ::OrecFair::onSwitchTo;
       stm::stms[OrecFair].privatization_safe = false;
+      stm::stms[OrecFair].counts_validations = true;
   }
 }
@@ -18,6 +18,7 @@
  *    paper.  More details can be found in the OrecEager implementation.
  */
 
+#include <cstring>
 #include "../profiling.hpp"
 #include "../cm.hpp"
 #include "algs.hpp"
@@ -45,6 +46,8 @@ namespace {
       static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void commit_ro(TxThread*);
       static TM_FASTCALL void commit_rw(TxThread*);
+      static void read_block(STM_READ_BLOCK_SIG(,,,));
+      static void write_block(STM_WRITE_BLOCK_SIG(,,,));
 
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
       static void Initialize(int id, const char* name);
@@ -66,10 +69,13 @@ namespace {
       stm::stms[id].commit    = OrecLazy_Generic<CM>::commit_ro;
       stm::stms[id].read      = OrecLazy_Generic<CM>::read_ro;
       stm::stms[id].write     = OrecLazy_Generic<CM>::write_ro;
+      stm::stms[id].read_block  = OrecLazy_Generic<CM>::read_block;
+      stm::stms[id].write_block = OrecLazy_Generic<CM>::write_block;
       stm::stms[id].rollback  = OrecLazy_Generic<CM>::rollback;
       stm::stms[id].irrevoc   = irrevoc;
       stm::stms[id].switcher  = onSwitchTo;
       stm::stms[id].privatization_safe = false;
+      stm::stms[id].counts_validations = true;
   }
 
   /**
@@ -247,6 +253,74 @@ namespace {
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
   }
 
+  /**
+   *  OrecLazy block read:
+   *
+   *    As in read_ro, but for each run of words that share an orec, we copy
+   *    the run and then check the orec once.  Once there are buffered
+   *    writes, each word needs a RAW check, so we use the word barriers
+   *    instead.
+   */
+  template <class CM>
+  void
+  OrecLazy_Generic<CM>::read_block(STM_READ_BLOCK_SIG(tx,to,addr,words))
+  {
+      if (tx->writes.size()) {
+          stm::read_block_fallback(tx, to, addr, words);
+          return;
+      }
+
+      size_t i = 0;
+      while (i < words) {
+          // find the run of words covered by this orec
+          orec_t* o = get_orec(addr + i);
+          size_t j = i + 1;
+          while ((j < words) && (get_orec(addr + j) == o))
+              ++j;
+
+          while (true) {
+              // read the run, then check the orec
+              memcpy(to + i, addr + i, (j - i) * sizeof(void*));
+              CFENCE;
+              id_version_t ivt;
+              ivt.all = o->v.all;
+
+              // common case: new read to uncontended location
+              if (ivt.all <= tx->start_time) {
+                  tx->r_orecs.insert(o);
+                  break;
+              }
+
+              // if lock held, spin and retry
+              if (ivt.fields.lock) {
+                  spin64();
+                  continue;
+              }
+
+              // scale timestamp if ivt is too new, then try again
+              uintptr_t newts = timestamp.val;
+              validate(tx);
+              tx->start_time = newts;
+          }
+          i = j;
+      }
+  }
+
+  /**
+   *  OrecLazy block write:
+   *
+   *    Buffer every word, and switch to a writing context
+   */
+  template <class CM>
+  void
+  OrecLazy_Generic<CM>::write_block(STM_WRITE_BLOCK_SIG(tx,addr,from,words))
+  {
+      for (size_t i = 0; i < words; ++i)
+          tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr + i, from[i],
+                                                              ~0x0)));
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
   /**
    *  OrecLazy rollback:
    *
@@ -303,10 +377,13 @@ namespace {
    */
   void
   validate(TxThread* tx) {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
       foreach (OrecList, i, tx->r_orecs)
           // abort if orec locked, or if unlocked but timestamp too new
           if ((*i)->v.all > tx->start_time)
               tx->tmabort(tx);
+      STM_PERF_LEAVE(tx);
   }
 
   /**
@@ -329,7 +406,8 @@ namespace {
     MACRO(OrecLazy, HyperAggressiveCM)          \
     MACRO(OrecLazyHour, HourglassCM)            \
     MACRO(OrecLazyBackoff, BackoffCM)           \
-    MACRO(OrecLazyHB, HourglassBackoffCM)
+    MACRO(OrecLazyHB, HourglassBackoffCM)       \
+    MACRO(OrecLazyShrink, ShrinkCM)
 
 #define INIT_ORECLAZY(ID, CM)                       \
     template <>                                     \
@@ -0,0 +1,397 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  OrecLazyRegion Implementation
+ *
+ *    This is OrecLazy with a two-level orec table.  Every REGION_ORECS
+ *    consecutive orecs are summarized by a region_t, which holds the newest
+ *    version released into any of them, and a count of the writers that
+ *    currently hold locks among them.  Reads are logged per region, as a
+ *    bitmask of the orecs read, so a transaction that reads many nearby
+ *    locations has a short read log.  Validation checks each region once:
+ *    if no writer is in the region, and nothing newer than our start time was
+ *    released into it, none of its orecs can have changed.  Otherwise we fall
+ *    back to checking the orecs named by the mask.
+ *
+ *    A writer enters the regions of its locks before it writes back, and
+ *    leaves them only after raising their versions to its end time, so a
+ *    reader that sees no writers in a region, and then an old version,
+ *    knows that nobody has written into the region since it started.
+ *
+ *    Other algorithms do not maintain the regions, so onSwitchTo raises all
+ *    of them to the timestamp, which is at least the version of every orec.
+ */
+
+#include "../profiling.hpp"
+#include "algs.hpp"
+#include "RedoRAWUtils.hpp"
+
+using stm::TxThread;
+using stm::get_orec;
+using stm::get_region_index;
+using stm::WriteSetEntry;
+using stm::OrecList;
+using stm::RegionReadList;
+using stm::region_read_t;
+using stm::WriteSet;
+using stm::orec_t;
+using stm::orecs;
+using stm::regions;
+using stm::timestamp;
+using stm::timestamp_max;
+using stm::id_version_t;
+using stm::REGION_ORECS;
+using stm::NUM_REGIONS;
+
+
+/**
+ *  Declare the functions that we're going to implement, so that we can avoid
+ *  circular dependencies.
+ */
+namespace {
+  struct OrecLazyRegion
+  {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
+      static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void commit_ro(TxThread*);
+      static TM_FASTCALL void commit_rw(TxThread*);
+
+      static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool irrevoc(TxThread*);
+      static void onSwitchTo();
+      static NOINLINE void validate(TxThread*);
+  };
+
+  /**
+   *  Add an orec to the read log.  Consecutive reads in the same region
+   *  share an entry.
+   */
+  TM_INLINE
+  inline void log_read(TxThread* tx, orec_t* o)
+  {
+      uint32_t r = get_region_index(o);
+      uint64_t bit = ((uint64_t)1) << ((o - orecs) % REGION_ORECS);
+      if (tx->r_regions.size() && ((tx->r_regions.end() - 1)->region == r))
+          (tx->r_regions.end() - 1)->mask |= bit;
+      else
+          tx->r_regions.insert(region_read_t(r, bit));
+  }
+
+  /**
+   *  Check one read log entry: at region granularity if the region is quiet,
+   *  and otherwise orec by orec.  Orecs that we hold are valid, since we
+   *  validated them when we locked them.
+   */
+  TM_INLINE
+  inline bool region_valid(TxThread* tx, region_read_t* e)
+  {
+      stm::region_t* r = &regions[e->region];
+      if (r->writers == 0) {
+          CFENCE;
+          if (r->v <= tx->start_time)
+              return true;
+      }
+      orec_t* o = &orecs[e->region * REGION_ORECS];
+      for (uint64_t m = e->mask; m; m >>= 1, ++o) {
+          if (!(m & 1))
+              continue;
+          uintptr_t ivt = o->v.all;
+          if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
+              return false;
+      }
+      return true;
+  }
+
+  /**
+   *  OrecLazyRegion begin:
+   *
+   *    Sample the timestamp and prepare local vars
+   */
+  bool
+  OrecLazyRegion::begin(TxThread* tx)
+  {
+      tx->allocator.onTxBegin();
+      tx->start_time = timestamp.val;
+      return false;
+  }
+
+  /**
+   *  OrecLazyRegion commit (read-only context)
+   *
+   *    We just reset local fields and we're done
+   */
+  void
+  OrecLazyRegion::commit_ro(TxThread* tx)
+  {
+      tx->r_regions.reset();
+      OnReadOnlyCommit(tx);
+  }
+
+  /**
+   *  OrecLazyRegion commit (writing context)
+   *
+   *    As in OrecLazy, but we enter the region of each lock when we take it,
+   *    and raise the region's version before we leave it.  Consecutive locks
+   *    in the same region only enter it once; rollback releases the locks in
+   *    the same order, and so leaves the same regions.
+   */
+  void
+  OrecLazyRegion::commit_rw(TxThread* tx)
+  {
+      // acquire locks
+      uint32_t last = NUM_REGIONS;
+      foreach (WriteSet, i, tx->writes) {
+          // get orec, read its version#
+          orec_t* o = get_orec(i->addr);
+          uintptr_t ivt = o->v.all;
+
+          // lock all orecs, unless already locked
+          if (ivt <= tx->start_time) {
+              // abort if cannot acquire
+              if (!bcasptr(&o->v.all, ivt, tx->my_lock.all))
+                  tx->tmabort(tx);
+              // save old version to o->p, remember that we hold the lock
+              o->p = ivt;
+              tx->locks.insert(o);
+              // enter the region before we can write into it
+              uint32_t r = get_region_index(o);
+              if (r != last) {
+                  last = r;
+                  faaptr(&regions[r].writers, 1);
+              }
+          }
+          // else if we don't hold the lock abort
+          else if (ivt != tx->my_lock.all) {
+              tx->tmabort(tx);
+          }
+      }
+
+      // validate
+      foreach (RegionReadList, i, tx->r_regions)
+          if (!region_valid(tx, i))
+              tx->tmabort(tx);
+
+      // run the redo log
+      tx->writes.writeback();
+
+      // increment the global timestamp, release locks
+      uintptr_t end_time = 1 + faiptr(&timestamp.val);
+      foreach (OrecList, i, tx->locks)
+          (*i)->v.all = end_time;
+
+      // publish the new version in our regions, then leave them
+      last = NUM_REGIONS;
+      foreach (OrecList, i, tx->locks) {
+          uint32_t r = get_region_index(*i);
+          if (r == last)
+              continue;
+          last = r;
+          uintptr_t v = regions[r].v;
+          while ((v < end_time) && !bcasptr(&regions[r].v, v, end_time))
+              v = regions[r].v;
+          faaptr(&regions[r].writers, -1);
+      }
+
+      // clean-up
+      tx->r_regions.reset();
+      tx->writes.reset();
+      tx->locks.reset();
+      OnReadWriteCommit(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  OrecLazyRegion read (read-only context):
+   *
+   *    Same as OrecLazy, except for the way we log the orec
+   */
+  void*
+  OrecLazyRegion::read_ro(STM_READ_SIG(tx,addr,))
+  {
+      // get the orec addr
+      orec_t* o = get_orec(addr);
+      while (true) {
+          // read the location
+          void* tmp = *addr;
+          CFENCE;
+          // check the orec
+          id_version_t ivt;
+          ivt.all = o->v.all;
+
+          // common case: new read to uncontended location
+          if (ivt.all <= tx->start_time) {
+              log_read(tx, o);
+              return tmp;
+          }
+
+          // if lock held, spin and retry
+          if (ivt.fields.lock) {
+              spin64();
+              continue;
+          }
+
+          // scale timestamp if ivt is too new, then try again
+          uintptr_t newts = timestamp.val;
+          validate(tx);
+          tx->start_time = newts;
+      }
+  }
+
+  /**
+   *  OrecLazyRegion read (writing context):
+   *
+   *    Just like read-only context, but must check the write set first
+   */
+  void*
+  OrecLazyRegion::read_rw(STM_READ_SIG(tx,addr,mask))
+  {
+      // check the log for a RAW hazard, we expect to miss
+      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+      bool found = tx->writes.find(log);
+      REDO_RAW_CHECK(found, log, mask);
+
+      // reuse the ReadRO barrier, which is adequate here---reduces LOC
+      void* val = read_ro(tx, addr STM_MASK(mask));
+      REDO_RAW_CLEANUP(val, found, log, mask);
+      return val;
+  }
+
+  /**
+   *  OrecLazyRegion write (read-only context):
+   *
+   *    Buffer the write, and switch to a writing context
+   */
+  void
+  OrecLazyRegion::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      // add to redo log
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
+  /**
+   *  OrecLazyRegion write (writing context):
+   *
+   *    Just buffer the write
+   */
+  void
+  OrecLazyRegion::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      // add to redo log
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+  }
+
+  /**
+   *  OrecLazyRegion rollback:
+   *
+   *    Release any locks we acquired (if we aborted during a commit()
+   *    operation), leave their regions, and then reset local lists.  The
+   *    orecs go back to their old versions, which their regions already
+   *    cover.
+   */
+  stm::scope_t*
+  OrecLazyRegion::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  {
+      PreRollback(tx);
+
+      // Perform writes to the exception object if there were any... taking the
+      // branch overhead without concern because we're not worried about
+      // rollback overheads.
+      STM_ROLLBACK(tx->writes, except, len);
+
+      // release the locks and restore version numbers
+      uint32_t last = NUM_REGIONS;
+      foreach (OrecList, i, tx->locks) {
+          (*i)->v.all = (*i)->p;
+          uint32_t r = get_region_index(*i);
+          if (r != last) {
+              last = r;
+              faaptr(&regions[r].writers, -1);
+          }
+      }
+
+      // undo memory operations, reset lists
+      tx->r_regions.reset();
+      tx->writes.reset();
+      tx->locks.reset();
+      return PostRollback(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  OrecLazyRegion in-flight irrevocability:
+   *
+   *    Either commit the transaction or return false.  As in OrecLazy, we
+   *    just return false.
+   */
+  bool
+  OrecLazyRegion::irrevoc(TxThread*)
+  {
+      return false;
+  }
+
+  /**
+   *  OrecLazyRegion validation:
+   *
+   *    We only call this when in-flight, which means that we don't have any
+   *    locks, and so no region of ours has a writer on our behalf.
+   */
+  void
+  OrecLazyRegion::validate(TxThread* tx)
+  {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
+      foreach (RegionReadList, i, tx->r_regions)
+          if (!region_valid(tx, i))
+              tx->tmabort(tx);
+      STM_PERF_LEAVE(tx);
+  }
+
+  /**
+   *  Switch to OrecLazyRegion:
+   *
+   *    As in OrecLazy, the timestamp must be >= the maximum value of any
+   *    orec.  Since other algorithms don't maintain the regions, we then raise
+   *    every region to the timestamp.  No transaction is running, so there
+   *    are no writers in any region.
+   */
+  void
+  OrecLazyRegion::onSwitchTo()
+  {
+      timestamp.val = MAXIMUM(timestamp.val, timestamp_max.val);
+      for (uint32_t i = 0; i < NUM_REGIONS; ++i)
+          regions[i].v = timestamp.val;
+  }
+}
+
+namespace stm {
+  /**
+   *  OrecLazyRegion initialization
+   */
+  template<>
+  void initTM<OrecLazyRegion>()
+  {
+      // set the name
+      stm::stms[OrecLazyRegion].name      = "OrecLazyRegion";
+
+      // set the pointers
+      stm::stms[OrecLazyRegion].begin     = ::OrecLazyRegion::begin;
+      stm::stms[OrecLazyRegion].commit    = ::OrecLazyRegion::commit_ro;
+      stm::stms[OrecLazyRegion].read      = ::OrecLazyRegion::read_ro;
+      stm::stms[OrecLazyRegion].write     = ::OrecLazyRegion::write_ro;
+      stm::stms[OrecLazyRegion].rollback  = ::OrecLazyRegion::rollback;
+      stm::stms[OrecLazyRegion].irrevoc   = ::OrecLazyRegion::irrevoc;
+      stm::stms[OrecLazyRegion].switcher  = ::OrecLazyRegion::onSwitchTo;
+      stm::stms[OrecLazyRegion].privatization_safe = false;
+      stm::stms[OrecLazyRegion].counts_validations = true;
+  }
+}
@@ -20,6 +20,20 @@
  *    In addition, the lead thread uses in-place writes, via a special
  *    version of the read and write functions.  However, the lead thread
  *    can't self-abort.
+ *
+ *    PipelineDet is the same algorithm with a deterministic order.  Each
+ *    participating thread joins a lane (see stm::det_join), and the order is
+ *    round-robin over the lanes: the k-th transaction of lane l gets the
+ *    l-th slot of round k.  A transaction keeps its slot when it aborts, and
+ *    each transaction validates against exactly the writes of the slots
+ *    before it, so if every thread runs the same transactions for the same
+ *    input, the final state is the same on every run.  Transactions still
+ *    run speculatively in parallel; only commits wait their turn.  The price
+ *    is that a lane which is between transactions holds up the lanes after
+ *    it, so threads should leave (stm::det_leave) before they block or stop
+ *    running transactions.  The slots of lanes that have left are skipped.
+ *    A thread that is not in a lane (e.g. during initialization) has no
+ *    slot, so its transactions run alone and irrevocably, outside the order.
  */
 
 #include "../profiling.hpp"
@@ -39,6 +53,7 @@ using stm::OrecList;
 using stm::WriteSet;
 using stm::UNRECOVERABLE;
 using stm::WriteSetEntry;
+using stm::pad_word_t;
 
 
 /**
@@ -46,7 +61,9 @@ using stm::WriteSetEntry;
  *  circular dependencies.
  */
 namespace {
-  struct Pipeline {
+  template <class ORDER>
+  struct Pipeline_Generic {
+      static void Initialize(int id, const char* name);
       static TM_FASTCALL bool begin(TxThread*);
       static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
       static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
@@ -65,6 +82,122 @@ namespace {
       static NOINLINE void validate(TxThread*, uintptr_t finish_cache);
   };
 
+  /**
+   *  Pipeline order: a global counter hands out the order at begin time.
+   */
+  struct FifoOrder
+  {
+      static void acquire(TxThread* tx)
+      {
+          tx->order = 1 + faiptr(&timestamp.val);
+      }
+      static void catch_up() { }
+      static void wait() { }
+      static void onCommit(TxThread*) { }
+      static void onSwitchTo() { }
+  };
+
+  /**
+   *  Metadata for PipelineDet: the number of lanes, the order just before
+   *  slot 0 of round 0, and one more than the next round of each lane, so
+   *  that 0 means the lane has not joined.
+   */
+  pad_word_t det_lanes = {0};
+  pad_word_t det_base  = {0};
+  pad_word_t det_round[stm::MAX_THREADS] = {{0}};
+
+  /**
+   *  PipelineDet order: slot l of round k comes right after slot l-1 of
+   *  round k, or slot lanes-1 of round k-1 when l is 0.
+   */
+  struct DetOrder
+  {
+      /**
+       *  A transaction outside of every lane becomes irrevocable instead.
+       *  It holds no slot, so it can wait for the lanes to drain and then
+       *  restart alone.
+       */
+      static void acquire(TxThread* tx)
+      {
+          if (tx->det_lane < 0)
+              stm::become_irrevoc();
+          tx->order = det_base.val + 1 +
+              (det_round[tx->det_lane].val - 1) * det_lanes.val + tx->det_lane;
+      }
+
+      /**
+       *  Skip over the slots of lanes that have left, or that joined after
+       *  the slot's round.  The transaction that owns the next slot is the
+       *  only other writer of last_complete, and a skipped slot has no
+       *  owner, so a CAS is enough.
+       */
+      static void catch_up()
+      {
+          uintptr_t lanes = det_lanes.val;
+          if (!lanes)
+              return;
+          while (true) {
+              uintptr_t lc = last_complete.val;
+              uintptr_t next = lc - det_base.val;
+              uintptr_t r = det_round[next % lanes].val;
+              if (r && (r - 1 <= next / lanes))
+                  return;
+              bcasptr(&last_complete.val, lc, lc + 1);
+          }
+      }
+
+      /**
+       *  Waiting for our turn may mean waiting for a lane that is not
+       *  running, so let it have the CPU
+       */
+      static void wait()
+      {
+          catch_up();
+          yield_cpu();
+      }
+
+      /**
+       *  Keep timestamp ahead of every orec, for the algorithms we may
+       *  switch to, and move to the lane's next round.
+       */
+      static void onCommit(TxThread* tx)
+      {
+          timestamp.val = tx->order;
+          ++det_round[tx->det_lane].val;
+      }
+
+      /*** Every lane that has joined starts over at round 0 */
+      static void onSwitchTo()
+      {
+          det_base.val = timestamp.val;
+          for (uint32_t i = 0; i < stm::MAX_THREADS; ++i)
+              if (det_round[i].val)
+                  det_round[i].val = 1;
+      }
+  };
+
+  /**
+   *  Pipeline initialization
+   */
+  template <class ORDER>
+  void
+  Pipeline_Generic<ORDER>::Initialize(int id, const char* name)
+  {
+      // set the name
+      stm::stms[id].name      = name;
+
+      // set the pointers
+      stm::stms[id].begin     = Pipeline_Generic<ORDER>::begin;
+      stm::stms[id].commit    = Pipeline_Generic<ORDER>::commit_ro;
+      stm::stms[id].read      = Pipeline_Generic<ORDER>::read_ro;
+      stm::stms[id].write     = Pipeline_Generic<ORDER>::write_ro;
+      stm::stms[id].read_turbo = Pipeline_Generic<ORDER>::read_turbo;
+      stm::stms[id].rollback  = Pipeline_Generic<ORDER>::rollback;
+      stm::stms[id].irrevoc   = Pipeline_Generic<ORDER>::irrevoc;
+      stm::stms[id].switcher  = Pipeline_Generic<ORDER>::onSwitchTo;
+      stm::stms[id].privatization_safe = true;
+  }
+
   /**
    *  Pipeline begin:
    *
@@ -77,15 +210,17 @@ namespace {
    *    ts_cache and order tells how many transactions need to commit.  Whenever
    *    one does, this tx will need to validate.
    */
+  template <class ORDER>
   bool
-  Pipeline::begin(TxThread* tx)
+  Pipeline_Generic<ORDER>::begin(TxThread* tx)
   {
       tx->allocator.onTxBegin();
 
       // only get a new start time if we didn't just abort
       if (tx->order == -1)
-          tx->order = 1 + faiptr(&timestamp.val);
+          ORDER::acquire(tx);
 
+      ORDER::catch_up();
       tx->ts_cache = last_complete.val;
       if (tx->ts_cache == ((uintptr_t)tx->order - 1))
           GoTurbo(tx, read_turbo, write_turbo, commit_turbo);
@@ -100,11 +235,13 @@ namespace {
    *    overhead, but it gives SGLA (in the [Menon SPAA 2008] sense)
    *    semantics.
    */
+  template <class ORDER>
   void
-  Pipeline::commit_ro(TxThread* tx)
+  Pipeline_Generic<ORDER>::commit_ro(TxThread* tx)
   {
       // wait our turn, then validate
       while (last_complete.val != ((uintptr_t)tx->order - 1)) {
+          ORDER::wait();
           // in this wait loop, we need to check if an adaptivity action is
           // underway :(
           if (TxThread::tmbegin != begin)
@@ -118,6 +255,7 @@ namespace {
               tx->tmabort(tx);
       }
       // mark self as complete
+      ORDER::onCommit(tx);
       last_complete.val = tx->order;
 
       // set status to committed...
@@ -136,11 +274,13 @@ namespace {
    *    acquisition is with naked stores, and it is on a path that always
    *    commits.
    */
+  template <class ORDER>
   void
-  Pipeline::commit_rw(TxThread* tx)
+  Pipeline_Generic<ORDER>::commit_rw(TxThread* tx)
   {
       // wait our turn, validate, writeback
       while (last_complete.val != ((uintptr_t)tx->order - 1)) {
+          ORDER::wait();
           if (TxThread::tmbegin != begin)
               tx->tmabort(tx);
       }
@@ -162,6 +302,7 @@ namespace {
           // write-back
           *i->addr = i->val;
       }
+      ORDER::onCommit(tx);
       last_complete.val = tx->order;
 
       // set status to committed...
@@ -182,10 +323,12 @@ namespace {
    *    NB: we do not distinguish between RO and RW... we should, and could
    *        via tx->writes
    */
+  template <class ORDER>
   void
-  Pipeline::commit_turbo(TxThread* tx)
+  Pipeline_Generic<ORDER>::commit_turbo(TxThread* tx)
   {
       CFENCE;
+      ORDER::onCommit(tx);
       last_complete.val = tx->order;
 
       // set status to committed...
@@ -204,8 +347,9 @@ namespace {
    *    commit time is determined at begin time!), we can skip pre-validation.
    *    Otherwise, this is a standard orec read function.
    */
+  template <class ORDER>
   void*
-  Pipeline::read_ro(STM_READ_SIG(tx,addr,))
+  Pipeline_Generic<ORDER>::read_ro(STM_READ_SIG(tx,addr,))
   {
       void* tmp = *addr;
       CFENCE; // RBR between dereference and orec check
@@ -227,8 +371,9 @@ namespace {
   /**
    *  Pipeline read (writing transaction)
    */
+  template <class ORDER>
   void*
-  Pipeline::read_rw(STM_READ_SIG(tx,addr,mask))
+  Pipeline_Generic<ORDER>::read_rw(STM_READ_SIG(tx,addr,mask))
   {
       // check the log for a RAW hazard, we expect to miss
       WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
@@ -257,8 +402,9 @@ namespace {
   /**
    *  Pipeline read (turbo mode)
    */
+  template <class ORDER>
   void*
-  Pipeline::read_turbo(STM_READ_SIG(,addr,))
+  Pipeline_Generic<ORDER>::read_turbo(STM_READ_SIG(,addr,))
   {
       return *addr;
   }
@@ -266,8 +412,9 @@ namespace {
   /**
    *  Pipeline write (read-only context)
    */
+  template <class ORDER>
   void
-  Pipeline::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  Pipeline_Generic<ORDER>::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
   {
       // record the new value in a redo log
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
@@ -277,8 +424,9 @@ namespace {
   /**
    *  Pipeline write (writing context)
    */
+  template <class ORDER>
   void
-  Pipeline::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  Pipeline_Generic<ORDER>::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
   {
       // record the new value in a redo log
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
@@ -289,8 +437,9 @@ namespace {
    *
    *    The oldest transaction needs to mark the orec before writing in-place.
    */
+  template <class ORDER>
   void
-  Pipeline::write_turbo(STM_WRITE_SIG(tx,addr,val,mask))
+  Pipeline_Generic<ORDER>::write_turbo(STM_WRITE_SIG(tx,addr,val,mask))
   {
       orec_t* o = get_orec(addr);
       o->v.all = tx->order;
@@ -307,8 +456,9 @@ namespace {
    *    NB: Self-abort is not supported in Pipeline.  Adding undo logging to
    *        turbo mode would resolve the issue.
    */
+  template <class ORDER>
   stm::scope_t*
-  Pipeline::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  Pipeline_Generic<ORDER>::rollback(STM_ROLLBACK_SIG(tx, except, len))
   {
       PreRollback(tx);
       // we cannot be in fast mode
@@ -330,10 +480,16 @@ namespace {
 
   /**
    *  Pipeline in-flight irrevocability:
+   *
+   *    A transaction that has an order cannot give it up, since later
+   *    transactions wait for it.  One without an order (a PipelineDet
+   *    transaction outside of every lane) can abort and restart irrevocably.
    */
-  bool Pipeline::irrevoc(TxThread*)
+  template <class ORDER>
+  bool Pipeline_Generic<ORDER>::irrevoc(TxThread* tx)
   {
-      UNRECOVERABLE("Pipeline Irrevocability not yet supported");
+      if (tx->order != -1)
+          UNRECOVERABLE("Pipeline Irrevocability not yet supported");
       return false;
   }
 
@@ -344,8 +500,9 @@ namespace {
    *    turbo mode.  Note that to do the switch, the current write set must be
    *    written to memory.
    */
+  template <class ORDER>
   void
-  Pipeline::validate(TxThread* tx, uintptr_t finish_cache)
+  Pipeline_Generic<ORDER>::validate(TxThread* tx, uintptr_t finish_cache)
   {
       foreach (OrecList, i, tx->r_orecs) {
           // read this orec
@@ -386,34 +543,71 @@ namespace {
    *
    *    Also, all threads' order values must be -1
    */
+  template <class ORDER>
   void
-  Pipeline::onSwitchTo()
+  Pipeline_Generic<ORDER>::onSwitchTo()
   {
       timestamp.val = MAXIMUM(timestamp.val, timestamp_max.val);
       last_complete.val = timestamp.val;
       for (uint32_t i = 0; i < threadcount.val; ++i)
           threads[i]->order = -1;
+      ORDER::onSwitchTo();
   }
 }
 
+// Register Pipeline initializer functions. Do this as declaratively as
+// possible. Remember that they need to be in the stm:: namespace.
+#define FOREACH_PIPELINE(MACRO)                 \
+    MACRO(Pipeline, FifoOrder)                  \
+    MACRO(PipelineDet, DetOrder)
+
+#define INIT_PIPELINE(ID, ORDER)                   \
+    template <>                                    \
+    void initTM<ID>() {                            \
+        Pipeline_Generic<ORDER>::Initialize(ID, #ID); \
+    }
+
 namespace stm {
+  FOREACH_PIPELINE(INIT_PIPELINE)
+
   /**
-   *  Pipeline initialization
+   *  Join lane 'lane' of 'lanes' for PipelineDet.  Every participating
+   *  thread must pass the same 'lanes'.  The lane starts at the first of
+   *  its slots that has not been passed yet, so joining is deterministic
+   *  when no transaction is running, e.g. between barriers.
    */
-  template<>
-  void initTM<Pipeline>()
+  void det_join(uint32_t lane, uint32_t lanes)
   {
-      // set the name
-      stms[Pipeline].name      = "Pipeline";
+      if (lane >= lanes || lanes > MAX_THREADS)
+          UNRECOVERABLE("det_join: lane out of range");
+      Self->det_lane = lane;
+      det_lanes.val = lanes;
+
+      // publish our round, then make sure nobody skipped its slot in the
+      // meantime
+      uintptr_t r, slot;
+      do {
+          uintptr_t lc = last_complete.val, base = det_base.val;
+          r = (lc > base + lane) ? (lc - base - lane - 1) / lanes + 1 : 0;
+          det_round[lane].val = r + 1;
+          WBR;
+          slot = base + 1 + r * lanes + lane;
+      } while (last_complete.val >= slot);
+  }
 
-      // set the pointers
-      stms[Pipeline].begin     = ::Pipeline::begin;
-      stms[Pipeline].commit    = ::Pipeline::commit_ro;
-      stms[Pipeline].read      = ::Pipeline::read_ro;
-      stms[Pipeline].write     = ::Pipeline::write_ro;
-      stms[Pipeline].rollback  = ::Pipeline::rollback;
-      stms[Pipeline].irrevoc   = ::Pipeline::irrevoc;
-      stms[Pipeline].switcher  = ::Pipeline::onSwitchTo;
-      stms[Pipeline].privatization_safe = true;
+  /**
+   *  Leave PipelineDet's order.  Other lanes stop waiting for ours, so call
+   *  this outside of transactions, before blocking or exiting.
+   */
+  void det_leave()
+  {
+      TxThread* tx = Self;
+      if (tx->det_lane < 0)
+          return;
+      det_round[tx->det_lane].val = 0;
+      tx->det_lane = -1;
   }
 }
+
+#undef FOREACH_PIPELINE
+#undef INIT_PIPELINE
@@ -0,0 +1,316 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  RingMW Implementation
+ *
+ *    This is the "multi writer" variant of the RingSTM algorithm, published
+ *    by Spear et al. at SPAA 2008.  As in RingSW, a writer commits by
+ *    claiming the next ring entry with a CAS on the timestamp, and publishing
+ *    its write filter there.  Unlike RingSW, writers do not hold the ring
+ *    while they write back: each writer only waits for earlier in-flight
+ *    writers whose write filters intersect its own, so writers with disjoint
+ *    write sets write back in parallel.
+ *
+ *    Since entries are claimed before their filters are copied, each entry
+ *    has an init word that holds the ring index of the filter it contains.
+ *    Writers finish in ring order, by advancing last_complete, so
+ *    last_complete is the frontier below which every writeback is done.
+ *    Transactions start at the frontier, and only check the filters of
+ *    entries after their start time.
+ */
+
+#include "../profiling.hpp"
+#include "algs.hpp"
+#include "RedoRAWUtils.hpp"
+
+using stm::TxThread;
+using stm::timestamp;
+using stm::timestamp_max;
+using stm::last_complete;
+using stm::ring_wf;
+using stm::RING_ELEMENTS;
+using stm::WriteSetEntry;
+
+
+/**
+ *  Declare the functions that we're going to implement, so that we can avoid
+ *  circular dependencies.
+ */
+namespace {
+  struct RingMW {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
+      static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void commit_ro(TxThread*);
+      static TM_FASTCALL void commit_rw(TxThread*);
+
+      static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool irrevoc(TxThread*);
+      static void onSwitchTo();
+      static NOINLINE void check_inflight(TxThread* tx, uintptr_t my_index);
+      static void check_ring(TxThread* tx, uintptr_t my_index);
+  };
+
+  /*** the ring index whose filter each ring entry currently holds */
+  volatile uintptr_t ring_init[RING_ELEMENTS] = {0};
+
+  /**
+   *  RingMW begin:
+   *
+   *    Every entry up to last_complete is written back, so we can start there
+   */
+  bool
+  RingMW::begin(TxThread* tx)
+  {
+      tx->allocator.onTxBegin();
+      tx->start_time = last_complete.val;
+      return false;
+  }
+
+  /**
+   *  RingMW commit (read-only):
+   */
+  void
+  RingMW::commit_ro(TxThread* tx)
+  {
+      // clear the filter and we are done
+      tx->rf->clear();
+      OnReadOnlyCommit(tx);
+  }
+
+  /**
+   *  RingMW commit (writing context):
+   *
+   *    Claim a ring entry with a CAS, if we are still valid, and publish our
+   *    write filter in it.  Then wait for any earlier writer that is still
+   *    writing back and might write the same locations, write back, and wait
+   *    for our turn to advance last_complete.  Waiting for our turn before
+   *    returning keeps RingMW privatization safe: once we return, no logically
+   *    earlier writer is still writing back.
+   */
+  void
+  RingMW::commit_rw(TxThread* tx)
+  {
+      // get a commit time, but only succeed in the CAS if this transaction
+      // is still valid
+      uintptr_t commit_time;
+      do {
+          commit_time = timestamp.val;
+          // intersect against all new entries, but don't wait for them to
+          // be written back: we have no more reads to do
+          if (commit_time != tx->start_time) {
+              check_ring(tx, commit_time);
+              tx->start_time = commit_time;
+          }
+      } while (!bcasptr(&timestamp.val, commit_time, commit_time + 1));
+
+      // copy the bits over (use SSE, not indirection), then say they're valid
+      uintptr_t my_index = commit_time + 1;
+      ring_wf[my_index % RING_ELEMENTS].fastcopy(tx->wf);
+      CFENCE;
+      ring_init[my_index % RING_ELEMENTS] = my_index;
+
+      // wait for earlier, incomplete writers whose writes might overlap ours
+      for (uintptr_t i = last_complete.val + 1; i < my_index; ++i) {
+          while (ring_init[i % RING_ELEMENTS] < i)
+              spin64();
+          if (ring_wf[i % RING_ELEMENTS].intersect(tx->wf))
+              while (last_complete.val < i)
+                  spin64();
+      }
+
+      // we're committed... run redo log, then advance the frontier in order
+      tx->writes.writeback();
+      while (last_complete.val != commit_time)
+          spin64();
+      CFENCE;
+      last_complete.val = my_index;
+
+      // clean up
+      tx->writes.reset();
+      tx->rf->clear();
+      tx->wf->clear();
+      OnReadWriteCommit(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  RingMW read (read-only transaction)
+   *
+   *    Entries are claimed before they are initialized, so we compare against
+   *    the timestamp, and check_inflight waits for the filters
+   */
+  void*
+  RingMW::read_ro(STM_READ_SIG(tx,addr,))
+  {
+      // read the value from memory, log the address, and validate
+      void* val = *addr;
+      CFENCE;
+      tx->rf->add(addr);
+      // get the latest claimed ring entry, return if we've seen it already
+      uintptr_t my_index = timestamp.val;
+      if (__builtin_expect(my_index != tx->start_time, false))
+          check_inflight(tx, my_index);
+      return val;
+  }
+
+  /**
+   *  RingMW read (writing transaction)
+   */
+  void*
+  RingMW::read_rw(STM_READ_SIG(tx,addr,mask))
+  {
+      // check the log for a RAW hazard, we expect to miss
+      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+      bool found = tx->writes.find(log);
+      REDO_RAW_CHECK(found, log, mask);
+
+      // reuse the ReadRO barrier, which is adequate here---reduces LOC
+      void* val = read_ro(tx, addr STM_MASK(mask));
+      REDO_RAW_CLEANUP(val, found, log, mask);
+      return val;
+  }
+
+  /**
+   *  RingMW write (read-only context)
+   */
+  void
+  RingMW::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      // buffer the write and update the filter
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      tx->wf->add(addr);
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
+  /**
+   *  RingMW write (writing context)
+   */
+  void
+  RingMW::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      tx->wf->add(addr);
+  }
+
+  /**
+   *  RingMW unwinder:
+   */
+  stm::scope_t*
+  RingMW::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  {
+      PreRollback(tx);
+
+      // Perform writes to the exception object if there were any... taking the
+      // branch overhead without concern because we're not worried about
+      // rollback overheads.
+      STM_ROLLBACK(tx->writes, except, len);
+
+      // reset filters and lists
+      tx->rf->clear();
+      if (tx->writes.size()) {
+          tx->writes.reset();
+          tx->wf->clear();
+      }
+      return PostRollback(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  RingMW in-flight irrevocability: use abort-and-restart
+   */
+  bool
+  RingMW::irrevoc(TxThread*)
+  {
+      return false;
+  }
+
+  /**
+   *  RingMW ring check
+   *
+   *    Intersect our read filter with every entry after our start time, up to
+   *    my_index, waiting for each entry's filter to be copied in.
+   */
+  void
+  RingMW::check_ring(TxThread* tx, uintptr_t my_index)
+  {
+      ++tx->num_validations;
+      STM_PERF_ENTER(tx, stm::PERF_VALIDATE);
+      for (uintptr_t i = my_index; i >= tx->start_time + 1; i--) {
+          while (ring_init[i % RING_ELEMENTS] < i)
+              spin64();
+          if (ring_wf[i % RING_ELEMENTS].intersect(tx->rf))
+              tx->tmabort(tx);
+      }
+
+      // detect ring rollover: start.ts must not have changed
+      if (timestamp.val > (tx->start_time + RING_ELEMENTS))
+          tx->tmabort(tx);
+      STM_PERF_LEAVE(tx);
+  }
+
+  /**
+   *  RingMW validation
+   *
+   *    check the ring for new entries and validate against them, then wait
+   *    for them to be written back, so that our later reads see their writes
+   */
+  void
+  RingMW::check_inflight(TxThread* tx, uintptr_t my_index)
+  {
+      check_ring(tx, my_index);
+
+      // wait for newest entry to be writeback-complete before returning
+      while (last_complete.val < my_index)
+          spin64();
+
+      // ensure this tx doesn't look at this entry again
+      tx->start_time = my_index;
+  }
+
+  /**
+   *  Switch to RingMW:
+   *
+   *    The timestamp and last_complete must be equal, and no ring entry may
+   *    claim to hold a filter from the future.  Some algs use the timestamp as
+   *    a zero-one mutex, so we restore it from timestamp_max, which is at
+   *    least every index we stored in ring_init.
+   */
+  void
+  RingMW::onSwitchTo()
+  {
+      timestamp.val = MAXIMUM(timestamp.val, timestamp_max.val);
+      last_complete.val = timestamp.val;
+  }
+}
+
+namespace stm {
+  /**
+   *  RingMW initialization
+   */
+  template<>
+  void initTM<RingMW>()
+  {
+      // set the name
+      stm::stms[RingMW].name      = "RingMW";
+
+      // set the pointers
+      stm::stms[RingMW].begin     = ::RingMW::begin;
+      stm::stms[RingMW].commit    = ::RingMW::commit_ro;
+      stm::stms[RingMW].read      = ::RingMW::read_ro;
+      stm::stms[RingMW].write     = ::RingMW::write_ro;
+      stm::stms[RingMW].rollback  = ::RingMW::rollback;
+      stm::stms[RingMW].irrevoc   = ::RingMW::irrevoc;
+      stm::stms[RingMW].switcher  = ::RingMW::onSwitchTo;
+      stm::stms[RingMW].privatization_safe = true;
+      stm::stms[RingMW].counts_validations = true;
+  }
+}
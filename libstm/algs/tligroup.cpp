@@ -0,0 +1,304 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  TLIGroup Implementation
+ *
+ *    This is TLI with a two-level invalidation scan.  In TLI, a committing
+ *    writer intersects its write filter with the read filter of every thread,
+ *    so commit cost grows with the thread count.  Here threads are split into
+ *    groups of TLI_GROUP consecutive ids, and each group has a summary filter
+ *    that its members add their reads to, as well as to their own filters.
+ *    A writer only scans the members of groups whose summary intersects its
+ *    write filter, and invalidates the conflicting members of a group in the
+ *    same pass.
+ *
+ *    Summaries only grow when readers add to them, so a writer that scans a
+ *    group also rebuilds its summary: it clears it, and then adds back the
+ *    current read filter of each member.  A reader adds to its own filter
+ *    before its summary, so any read whose summary bit the clear removes is
+ *    still in the member's filter when the writer looks at it.
+ */
+
+#include "../profiling.hpp"
+#include "algs.hpp"
+#include "RedoRAWUtils.hpp"
+
+using stm::TxThread;
+using stm::timestamp;
+using stm::threads;
+using stm::threadcount;
+using stm::filter_t;
+using stm::WriteSetEntry;
+
+
+/**
+ *  Declare the functions that we're going to implement, so that we can avoid
+ *  circular dependencies.
+ */
+namespace {
+  struct TLIGroup
+  {
+      static TM_FASTCALL bool begin(TxThread*);
+      static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
+      static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void commit_ro(TxThread*);
+      static TM_FASTCALL void commit_rw(TxThread*);
+
+      static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
+      static bool irrevoc(TxThread*);
+      static void onSwitchTo();
+  };
+
+  /*** threads per summary filter */
+  const uint32_t TLI_GROUP = 8;
+
+  /*** one summary filter per group of threads */
+  filter_t summaries[stm::MAX_THREADS / TLI_GROUP] TM_ALIGN(16);
+
+  /**
+   *  Rebuild the summary of group g, whose members end before thread 'end'.
+   *  The clear must precede our reads of the members' filters.  We gather
+   *  the filters privately, so that we only merge into the summary once.
+   */
+  NOINLINE void rebuild(uint32_t g, uint32_t end)
+  {
+      summaries[g].clear();
+      WBR;
+      filter_t rebuilt;
+      for (uint32_t i = g * TLI_GROUP; i < end; i++)
+          rebuilt.unionwith(*threads[i]->rf);
+      summaries[g].shared_unionwith(&rebuilt);
+  }
+
+  /**
+   *  TLIGroup begin:
+   */
+  bool
+  TLIGroup::begin(TxThread* tx)
+  {
+      // mark self as alive
+      tx->allocator.onTxBegin();
+      tx->alive = 1;
+      return false;
+  }
+
+  /**
+   *  TLIGroup commit (read-only):
+   */
+  void
+  TLIGroup::commit_ro(TxThread* tx)
+  {
+      // if the transaction is invalid, abort
+      if (__builtin_expect(tx->alive == 2, false))
+          tx->tmabort(tx);
+
+      // ok, all is good
+      tx->alive = 0;
+      tx->rf->clear();
+      OnReadOnlyCommit(tx);
+  }
+
+  /**
+   *  TLIGroup commit (writing context):
+   *
+   *    As in TLI, but we skip the groups whose summary does not intersect
+   *    our write filter.  If a summary intersects but no member does, its
+   *    bits are stale, so we rebuild it.
+   */
+  void
+  TLIGroup::commit_rw(TxThread* tx)
+  {
+      // if the transaction is invalid, abort
+      if (__builtin_expect(tx->alive == 2, false))
+          tx->tmabort(tx);
+
+      // grab the lock to stop the world
+      uintptr_t tmp = timestamp.val;
+      while (((tmp&1) == 1) || (!bcasptr(&timestamp.val, tmp, (tmp+1)))) {
+          tmp = timestamp.val;
+          spin64();
+      }
+
+      // double check that we're valid
+      if (__builtin_expect(tx->alive == 2,false)) {
+          timestamp.val = tmp + 2; // release the lock
+          tx->tmabort(tx);
+      }
+
+      // kill conflicting transactions, a group at a time
+      uint32_t count = threadcount.val;
+      for (uint32_t g = 0; g * TLI_GROUP < count; g++) {
+          if (!tx->wf->intersect(&summaries[g]))
+              continue;
+          uint32_t end = (g + 1) * TLI_GROUP;
+          if (end > count)
+              end = count;
+          bool hit = false;
+          for (uint32_t i = g * TLI_GROUP; i < end; i++) {
+              TxThread* o = threads[i];
+              if ((o->alive == 1) && (tx->wf->intersect(o->rf))) {
+                  o->alive = 2;
+                  hit = true;
+              }
+          }
+          if (!hit)
+              rebuild(g, end);
+      }
+
+      // do writeback
+      tx->writes.writeback();
+
+      // release the lock and clean up
+      tx->alive = 0;
+      timestamp.val = tmp+2;
+      tx->writes.reset();
+      tx->rf->clear();
+      tx->wf->clear();
+      OnReadWriteCommit(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  TLIGroup read (read-only transaction)
+   *
+   *    As in TLI, but the read is visible in our group's summary, too
+   */
+  void*
+  TLIGroup::read_ro(STM_READ_SIG(tx,addr,))
+  {
+      // push address into read filter, then into the summary, and ensure
+      // ordering w.r.t. the subsequent read of data
+      tx->rf->atomic_add(addr);
+      summaries[(tx->id - 1) / TLI_GROUP].shared_add(addr);
+
+      // get a consistent snapshot of the value
+      while (true) {
+          uintptr_t x1 = timestamp.val;
+          CFENCE;
+          void* val = *addr;
+          CFENCE;
+          // if the ts was even and unchanged, then the read is valid
+          bool ts_ok = !(x1&1) && (timestamp.val == x1);
+          CFENCE;
+          // if read valid, and we're not killed, return the value
+          if ((tx->alive == 1) && ts_ok)
+              return val;
+          // abort if we're killed
+          if (tx->alive == 2)
+              tx->tmabort(tx);
+      }
+  }
+
+  /**
+   *  TLIGroup read (writing transaction)
+   */
+  void*
+  TLIGroup::read_rw(STM_READ_SIG(tx,addr,mask))
+  {
+      // check the log for a RAW hazard, we expect to miss
+      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+      bool found = tx->writes.find(log);
+      REDO_RAW_CHECK(found, log, mask);
+
+      // reuse the ReadRO barrier, which is adequate here---reduces LOC
+      void* val = read_ro(tx, addr STM_MASK(mask));
+      REDO_RAW_CLEANUP(val, found, log, mask);
+      return val;
+  }
+
+  /**
+   *  TLIGroup write (read-only context)
+   */
+  void
+  TLIGroup::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      // buffer the write, update the filter
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      tx->wf->add(addr);
+      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
+  /**
+   *  TLIGroup write (writing context)
+   *
+   *    Just like the RO case
+   */
+  void
+  TLIGroup::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      tx->wf->add(addr);
+  }
+
+  /**
+   *  TLIGroup unwinder:
+   *
+   *    Our reads stay in the summary until a writer rebuilds it
+   */
+  stm::scope_t*
+  TLIGroup::rollback(STM_ROLLBACK_SIG(tx, except, len))
+  {
+      PreRollback(tx);
+
+      // Perform writes to the exception object if there were any... taking the
+      // branch overhead without concern because we're not worried about
+      // rollback overheads.
+      STM_ROLLBACK(tx->writes, except, len);
+
+      // clear filters and logs
+      tx->rf->clear();
+      if (tx->writes.size()) {
+          tx->writes.reset();
+          tx->wf->clear();
+      }
+      return PostRollback(tx, read_ro, write_ro, commit_ro);
+  }
+
+  /**
+   *  TLIGroup in-flight irrevocability: use abort-and-restart
+   */
+  bool TLIGroup::irrevoc(TxThread*) { return false; }
+
+  /**
+   *  Switch to TLIGroup:
+   *
+   *    Must be sure the timestamp is not odd.  Stale summary bits only cost
+   *    an extra scan, so we leave the summaries alone.
+   */
+  void TLIGroup::onSwitchTo()
+  {
+      if (timestamp.val & 1)
+          ++timestamp.val;
+  }
+}
+
+namespace stm {
+  /**
+   *  TLIGroup initialization
+   */
+  template<>
+  void initTM<TLIGroup>()
+  {
+      // set the name
+      stms[TLIGroup].name      = "TLIGroup";
+
+      // set the pointers
+      stms[TLIGroup].begin     = ::TLIGroup::begin;
+      stms[TLIGroup].commit    = ::TLIGroup::commit_ro;
+      stms[TLIGroup].read      = ::TLIGroup::read_ro;
+      stms[TLIGroup].write     = ::TLIGroup::write_ro;
+      stms[TLIGroup].rollback  = ::TLIGroup::rollback;
+      stms[TLIGroup].irrevoc   = ::TLIGroup::irrevoc;
+      stms[TLIGroup].switcher  = ::TLIGroup::onSwitchTo;
+      stms[TLIGroup].privatization_safe = true;
+  }
+}
@@ -41,6 +41,7 @@ namespace {
   struct TML {
       static TM_FASTCALL bool begin(TxThread*);
       static TM_FASTCALL void* read(STM_READ_SIG(,,));
+      static TM_FASTCALL void* read_ronly(STM_READ_SIG(,,));
       static TM_FASTCALL void write(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void commit(TxThread*);
 
@@ -104,6 +105,23 @@ namespace {
       return val;
   }
 
+  /**
+   *  TML read (declared read-only):
+   *
+   *    A declared read-only transaction never takes the lock by writing, so
+   *    we skip the check for it.  It can still take the lock by becoming
+   *    irrevocable, but that increments start_time too, so the check below
+   *    keeps passing.  For the same reason, commit must still check.
+   */
+  void*
+  TML::read_ronly(STM_READ_SIG(tx,addr,))
+  {
+      void* val = *addr;
+      // NB:  afterread_tml includes a CFENCE
+      afterread_TML(tx);
+      return val;
+  }
+
   /**
    *  TML write:
    *
@@ -179,6 +197,7 @@ namespace stm {
       stms[TML].begin     = ::TML::begin;
       stms[TML].commit    = ::TML::commit;
       stms[TML].read      = ::TML::read;
+      stms[TML].read_ronly = ::TML::read_ronly;
       stms[TML].write     = ::TML::write;
       stms[TML].rollback  = ::TML::rollback;
       stms[TML].irrevoc   = ::TML::irrevoc;
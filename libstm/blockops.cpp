@@ -0,0 +1,219 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  This file implements transactional bulk memory operations (tx_memcpy,
+ *  tx_memset, and tx_memcmp) for the library API.
+ *
+ *  Each operation is broken into chunks that are staged through a small,
+ *  word-aligned buffer on the stack.  Within a chunk, any unaligned prefix
+ *  or suffix of the shared range is handled with the per-thread word
+ *  barriers (masked under byte logging, read-modify-write under word
+ *  logging), and the aligned middle is handed to the per-thread block
+ *  barriers, which algorithms can implement with one metadata check per
+ *  orec and bulk copies.
+ */
+
+#include <cstring>
+#include <stm/txthread.hpp>
+#include <stm/trace.hpp>
+#include <stm/perf.hpp>
+
+using stm::TxThread;
+
+namespace
+{
+  /*** how many words we stage on the stack at a time */
+  const size_t CHUNK_WORDS = 64;
+  const size_t CHUNK_BYTES = CHUNK_WORDS * sizeof(void*);
+
+  /*** a word, viewed as an array of bytes */
+  union word_bytes_t
+  {
+      void*   word;
+      uint8_t bytes[sizeof(void*)];
+  };
+
+  /*** offset of an address within its word */
+  inline size_t offset_of(const void* addr)
+  {
+      return reinterpret_cast<uintptr_t>(addr) & (sizeof(void*) - 1);
+  }
+
+  /*** the word containing an address */
+  inline void** base_of(const void* addr)
+  {
+      return reinterpret_cast<void**>(reinterpret_cast<uintptr_t>(addr) &
+                                      ~(uintptr_t)(sizeof(void*) - 1));
+  }
+
+#if defined(STM_WS_BYTELOG)
+  /*** mask selecting bytes [i, j) of a word */
+  inline uintptr_t make_mask(size_t i, size_t j)
+  {
+      uintptr_t mask = 0;
+      for (size_t k = i; k < j; ++k)
+          mask |= ((uintptr_t)0xFF) << (8 * k);
+      return mask;
+  }
+#endif
+
+  /**
+   *  Transactionally read len bytes of shared memory at 'from' into the
+   *  private buffer 'to'.  len must be no more than CHUNK_BYTES.
+   */
+  void read_bytes(TxThread* tx, uint8_t* to, const uint8_t* from, size_t len)
+  {
+      STM_TRACE_ACCESS(tx, stm::TRACE_READ, from, len);
+      STM_PERF_ENTER(tx, stm::PERF_READ);
+
+      // unaligned prefix, or a range that fits within one word
+      size_t off = offset_of(from);
+      if (off || (len < sizeof(void*))) {
+          size_t end = (off + len < sizeof(void*)) ? off + len : sizeof(void*);
+          word_bytes_t w;
+          w.word = tx->tmread(tx, base_of(from) STM_MASK(make_mask(off, end)));
+          memcpy(to, w.bytes + off, end - off);
+          to += end - off;
+          from += end - off;
+          len -= end - off;
+      }
+
+      // aligned middle, staged through a word-aligned buffer
+      size_t words = len / sizeof(void*);
+      if (words) {
+          void* buf[CHUNK_WORDS];
+          tx->tmread_block(tx, buf, (void**)from, words);
+          memcpy(to, buf, words * sizeof(void*));
+          to += words * sizeof(void*);
+          from += words * sizeof(void*);
+          len -= words * sizeof(void*);
+      }
+
+      // unaligned suffix
+      if (len) {
+          word_bytes_t w;
+          w.word = tx->tmread(tx, (void**)from STM_MASK(make_mask(0, len)));
+          memcpy(to, w.bytes, len);
+      }
+      STM_PERF_LEAVE(tx);
+  }
+
+  /**
+   *  Transactionally write bytes [off, end) of the word at addr from 'from'.
+   *  With word logging we must read the enclosing word first, so that we do
+   *  not clobber its other bytes.
+   */
+  inline void
+  write_subword(TxThread* tx, void** addr, const uint8_t* from, size_t off,
+                size_t end)
+  {
+      word_bytes_t w;
+#if defined(STM_WS_BYTELOG)
+      w.word = NULL;
+#else
+      w.word = tx->tmread(tx, addr);
+#endif
+      memcpy(w.bytes + off, from, end - off);
+      tx->tmwrite(tx, addr, w.word STM_MASK(make_mask(off, end)));
+  }
+
+  /**
+   *  Transactionally write len bytes from the private buffer 'from' to
+   *  shared memory at 'to'.  len must be no more than CHUNK_BYTES.
+   */
+  void write_bytes(TxThread* tx, uint8_t* to, const uint8_t* from, size_t len)
+  {
+      STM_TRACE_ACCESS(tx, stm::TRACE_WRITE, to, len);
+      STM_PERF_ENTER(tx, stm::PERF_WRITE);
+
+      // unaligned prefix, or a range that fits within one word
+      size_t off = offset_of(to);
+      if (off || (len < sizeof(void*))) {
+          size_t end = (off + len < sizeof(void*)) ? off + len : sizeof(void*);
+          write_subword(tx, base_of(to), from, off, end);
+          to += end - off;
+          from += end - off;
+          len -= end - off;
+      }
+
+      // aligned middle, staged through a word-aligned buffer
+      size_t words = len / sizeof(void*);
+      if (words) {
+          void* buf[CHUNK_WORDS];
+          memcpy(buf, from, words * sizeof(void*));
+          tx->tmwrite_block(tx, (void**)to, buf, words);
+          to += words * sizeof(void*);
+          from += words * sizeof(void*);
+          len -= words * sizeof(void*);
+      }
+
+      // unaligned suffix
+      if (len)
+          write_subword(tx, (void**)to, from, 0, len);
+      STM_PERF_LEAVE(tx);
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  /**
+   *  Copy len bytes from shared memory at src to shared memory at dst.  As
+   *  with memcpy, the ranges must not overlap.
+   */
+  void tx_memcpy(void* dst, const void* src, size_t len, TxThread* tx)
+  {
+      uint8_t* d = static_cast<uint8_t*>(dst);
+      const uint8_t* s = static_cast<const uint8_t*>(src);
+      uint8_t buf[CHUNK_BYTES];
+      while (len) {
+          size_t n = (len < CHUNK_BYTES) ? len : CHUNK_BYTES;
+          read_bytes(tx, buf, s, n);
+          write_bytes(tx, d, buf, n);
+          d += n;
+          s += n;
+          len -= n;
+      }
+  }
+
+  /*** Set len bytes of shared memory at dst to c */
+  void tx_memset(void* dst, int c, size_t len, TxThread* tx)
+  {
+      uint8_t* d = static_cast<uint8_t*>(dst);
+      uint8_t buf[CHUNK_BYTES];
+      memset(buf, c, (len < CHUNK_BYTES) ? len : CHUNK_BYTES);
+      while (len) {
+          size_t n = (len < CHUNK_BYTES) ? len : CHUNK_BYTES;
+          write_bytes(tx, d, buf, n);
+          d += n;
+          len -= n;
+      }
+  }
+
+  /*** Compare len bytes of shared memory at a and b, as memcmp does */
+  int tx_memcmp(const void* a, const void* b, size_t len, TxThread* tx)
+  {
+      const uint8_t* pa = static_cast<const uint8_t*>(a);
+      const uint8_t* pb = static_cast<const uint8_t*>(b);
+      uint8_t bufa[CHUNK_BYTES];
+      uint8_t bufb[CHUNK_BYTES];
+      while (len) {
+          size_t n = (len < CHUNK_BYTES) ? len : CHUNK_BYTES;
+          read_bytes(tx, bufa, pa, n);
+          read_bytes(tx, bufb, pb, n);
+          if (int r = memcmp(bufa, bufb, n))
+              return r;
+          pa += n;
+          pb += n;
+          len -= n;
+      }
+      return 0;
+  }
+} // namespace stm
@@ -264,6 +264,313 @@ namespace stm
       static bool mayKill(TxThread*, uint32_t) { return true; }
   };
 
+  /**
+   *  Shrink CM: a scheduler in the spirit of Shrink (Dragojevic et al.,
+   *  PODC 09) and ATS (Yoo and Lee, SPAA 08).  Rather than serialize every
+   *  thread behind a repeat offender, as Hourglass does, we serialize the
+   *  offender behind the threads that it is likely to conflict with.
+   *
+   *  We predict that a retry writes what its aborted attempt wrote, and that
+   *  a running transaction writes what its thread last wrote.  Each thread
+   *  keeps a Bloom filter of its last write set, which it refreshes on
+   *  commit while anyone is being scheduled, and on abort.  After
+   *  ABORT_THRESHOLD consecutive aborts, a transaction's begin waits for
+   *  every in-flight transaction whose filter intersects its prediction to
+   *  finish its current attempt.  Threads that do not intersect keep running.
+   *
+   *  The write sets are read from the redo log, so this is only for
+   *  redo-log algorithms, which call onCommit and onAbort before resetting
+   *  the log.
+   */
+  struct ShrinkCM
+  {
+      static const uint32_t ABORT_THRESHOLD = 2;
+
+      /*** put the addresses in tx's redo log into f */
+      static void sign(TxThread* tx, filter_t* f)
+      {
+          f->clear();
+          foreach (WriteSet, i, tx->writes)
+              f->add(i->addr);
+      }
+
+      /**
+       *  On begin, wait behind each in-flight transaction that we expect to
+       *  conflict with.  We skip threads that are waiting themselves, so two
+       *  waiters cannot wait for each other.
+       */
+      static void onBegin(TxThread* tx)
+      {
+          if (tx->consec_aborts < ABORT_THRESHOLD)
+              return;
+          tx->shrink_waiting = 1;
+          WBR;
+          for (uint32_t i = 0; i < threadcount.val; ++i) {
+              TxThread* o = threads[i];
+              if ((o == tx) || !o->scope || o->shrink_waiting)
+                  continue;
+              if (!o->shrink_wsig->intersect(tx->shrink_pred))
+                  continue;
+              // wait for o's current attempt to commit or abort
+              uint64_t seen = o->num_commits + o->num_ro + o->num_aborts;
+              while (o->scope &&
+                     (o->num_commits + o->num_ro + o->num_aborts == seen))
+              {
+                  if (TxThread::tmbegin == begin_blocker) {
+                      tx->shrink_waiting = 0;
+                      tx->tmabort(tx);
+                  }
+                  spin64();
+              }
+          }
+          tx->shrink_waiting = 0;
+      }
+
+      /**
+       *  On abort, predict that the retry writes the same locations, and
+       *  publish that prediction.  An attempt that aborted before writing
+       *  anything tells us nothing, so it keeps the old prediction.  Once we
+       *  cross the threshold, ask the other threads to keep their filters
+       *  current.
+       */
+      static void onAbort(TxThread* tx)
+      {
+          if (tx->writes.size()) {
+              sign(tx, tx->shrink_wsig);
+              tx->shrink_pred->fastcopy(tx->shrink_wsig);
+          }
+          if ((tx->consec_aborts >= ABORT_THRESHOLD) && !tx->shrink_hot) {
+              tx->shrink_hot = true;
+              faiptr(&shrink_hot.val);
+          }
+      }
+
+      /**
+       *  On commit, refresh our filter if anyone is being scheduled, and
+       *  stop being scheduled ourselves
+       */
+      static void onCommit(TxThread* tx)
+      {
+          if (shrink_hot.val)
+              sign(tx, tx->shrink_wsig);
+          if (tx->shrink_hot) {
+              tx->shrink_hot = false;
+              faaptr(&shrink_hot.val, -1);
+          }
+      }
+
+      /**
+       *  During the transaction, always abort conflicting transactions
+       */
+      static bool mayKill(TxThread*, uint32_t) { return true; }
+  };
+
+  /**
+   *  Helpers for the work-weighted CMs below.  A transaction's work is the
+   *  number of locations its current attempt has opened, which we count
+   *  from the logs of the eager algorithms (OrEAU and ByEAU).  Each family
+   *  leaves the other's logs empty, so the sum is the work of whichever
+   *  family is running.
+   *
+   *  We read other threads' log sizes and counters while they run, so we
+   *  read each field once and tolerate stale values, as ShrinkCM does.
+   */
+  inline uintptr_t cm_work(TxThread* tx)
+  {
+      return tx->r_orecs.size() + tx->locks.size() +
+          tx->r_bytelocks.size() + tx->w_bytelocks.size();
+  }
+
+  /*** a thread's Karma priority: its work, including aborted attempts */
+  inline uintptr_t cm_karma(TxThread* tx)
+  {
+      return tx->cm_karma + cm_work(tx);
+  }
+
+  /*** changes whenever tx finishes an attempt */
+  inline uint64_t cm_attempts(TxThread* tx)
+  {
+      return tx->num_commits + tx->num_ro + tx->num_aborts;
+  }
+
+  /**
+   *  Give permission to kill o, and remember that we did.  The eager
+   *  algorithms acquire locks before they kill the readers, so without
+   *  this a loser could restart and take its locks back before the winner
+   *  gets to run (on an oversubscribed machine, every time).
+   */
+  inline bool cm_kill(TxThread* tx, TxThread* o)
+  {
+      o->cm_winner = tx->id;
+      return true;
+  }
+
+  /**
+   *  On begin, if someone killed our last attempt, wait for the attempt
+   *  that killed us to finish or start waiting itself.  If the winner has
+   *  already moved on, this waits out one more of its attempts, which is
+   *  harmless.  Stop if an algorithm switch is pending.
+   *
+   *  Two transactions can kill each other, and then both wait here.  We
+   *  count as waiting for the whole wait, so at least one of them sees the
+   *  other's flag and stops.
+   */
+  inline void cm_wait_for_winner(TxThread* tx)
+  {
+      uint32_t w = tx->cm_winner;
+      if (!w)
+          return;
+      tx->cm_winner = 0;
+      TxThread* o = threads[w - 1];
+      tx->cm_waiting = 1;
+      WBR;
+      uint64_t seen = cm_attempts(o);
+      while (o->scope && (cm_attempts(o) == seen) && !o->cm_waiting) {
+          if (TxThread::tmbegin == begin_blocker) {
+              tx->cm_waiting = 0;
+              tx->tmabort(tx);
+          }
+          spin64();
+      }
+      tx->cm_waiting = 0;
+  }
+
+  /**
+   *  Karma CM (Scherer and Scott, PODC 05): a transaction's priority is the
+   *  work it has done, and it keeps that work across aborts until it
+   *  commits.  A transaction may kill an enemy whose priority is no more
+   *  than its own plus the number of times it has been aborted, so a long
+   *  transaction that keeps losing eventually wins.  Otherwise it aborts
+   *  itself, keeping its priority.
+   *
+   *  This generalizes the Karma that is hard-coded in OrecFair.
+   */
+  struct KarmaCM
+  {
+      static void onBegin(TxThread* tx) { cm_wait_for_winner(tx); }
+
+      /*** On abort, bank the work of the attempt */
+      static void onAbort(TxThread* tx)
+      {
+          tx->cm_karma += cm_work(tx);
+      }
+
+      /*** On commit, start over */
+      static void onCommit(TxThread* tx)
+      {
+          tx->cm_karma = 0;
+      }
+
+      /*** Kill the enemy if we have done at least as much work */
+      static bool mayKill(TxThread* tx, uint32_t other)
+      {
+          TxThread* o = threads[other];
+          if (cm_karma(tx) + tx->consec_aborts >= cm_karma(o))
+              return cm_kill(tx, o);
+          return false;
+      }
+  };
+
+  /**
+   *  Polka CM (Scherer and Scott, PODC 05): Karma priorities, with
+   *  randomized exponential backoff.  Rather than abort itself, a
+   *  transaction with lower priority waits for the enemy, for as many
+   *  exponentially growing intervals as the difference in priority, and
+   *  then kills it.
+   */
+  struct PolkaCM
+  {
+      static void onBegin(TxThread* tx) { cm_wait_for_winner(tx); }
+
+      /*** On abort, bank the work of the attempt */
+      static void onAbort(TxThread* tx)
+      {
+          tx->cm_karma += cm_work(tx);
+      }
+
+      /*** On commit, start over */
+      static void onCommit(TxThread* tx)
+      {
+          tx->cm_karma = 0;
+      }
+
+      /**
+       *  Back off while the enemy's current attempt outranks us.  We stop
+       *  early if the enemy finishes the attempt, and abort ourselves if
+       *  someone kills us while we wait.
+       */
+      static bool mayKill(TxThread* tx, uint32_t other)
+      {
+          TxThread* o = threads[other];
+          uint64_t seen = cm_attempts(o);
+          uintptr_t mine = cm_karma(tx);
+          for (uint32_t i = 0; mine + i < cm_karma(o); ++i) {
+              if (!o->scope || (cm_attempts(o) != seen))
+                  break;
+              if (tx->alive == TX_ABORTED)
+                  return false;
+              // randomized wait, bounded by an exponentially increasing limit
+              uint32_t bits = i + BACKOFF_MIN;
+              bits = (bits > BACKOFF_MAX) ? BACKOFF_MAX : bits;
+              uint64_t stop_at = getElapsedTime() +
+                  (rand_r(&tx->seed) & ((1 << bits) - 1));
+              while (getElapsedTime() < stop_at) { spin64(); }
+          }
+          return cm_kill(tx, o);
+      }
+  };
+
+  /**
+   *  Greedy CM (Guerraoui, Herlihy and Pochon, PODC 05): each transaction
+   *  takes a timestamp when it first starts, and keeps it across aborts, so
+   *  it eventually becomes the oldest.  A transaction kills an enemy that
+   *  is younger or that is itself waiting; otherwise it waits for the older
+   *  enemy to finish its attempt or start waiting.  A waiting transaction
+   *  never waits on one that is itself waiting, so waits cannot deadlock.
+   *
+   *  We draw timestamps from greedy_ts, as Swiss does.
+   */
+  struct GreedyCM
+  {
+      /*** On the first attempt, take a timestamp */
+      static void onBegin(TxThread* tx)
+      {
+          if (!tx->consec_aborts)
+              tx->cm_ts = 1 + faiptr(&greedy_ts.val);
+          cm_wait_for_winner(tx);
+      }
+
+      static void onAbort(TxThread*) { }
+      static void onCommit(TxThread*) { }
+
+      /**
+       *  Wait behind an older enemy.  Once it finishes the attempt, we
+       *  decide again: if it committed, its next transaction is younger than
+       *  us, and if it aborted, it is still older and we yield to it.
+       */
+      static bool mayKill(TxThread* tx, uint32_t other)
+      {
+          TxThread* o = threads[other];
+          if ((o->cm_ts > tx->cm_ts) || o->cm_waiting)
+              return cm_kill(tx, o);
+
+          tx->cm_waiting = 1;
+          WBR;
+          uint64_t seen = cm_attempts(o);
+          while (o->scope && (cm_attempts(o) == seen) && !o->cm_waiting) {
+              if (tx->alive == TX_ABORTED) {
+                  tx->cm_waiting = 0;
+                  return false;
+              }
+              spin64();
+          }
+          tx->cm_waiting = 0;
+          if (o->cm_waiting || (o->cm_ts > tx->cm_ts))
+              return cm_kill(tx, o);
+          return false;
+      }
+  };
+
 }
 
 #endif // CM_HPP__
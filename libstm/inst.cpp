@@ -19,6 +19,11 @@
 
 namespace stm
 {
+  /**
+   *  Only install_algorithm writes this, and only while holding
+   *  begin_blocker, so a plain increment is enough
+   */
+  volatile uint64_t alg_switches = 0;
 
   void install_algorithm_local(int new_alg, TxThread* tx)
   {
@@ -26,6 +31,40 @@ namespace stm
       tx->tmread     = stms[new_alg].read;
       tx->tmwrite    = stms[new_alg].write;
       tx->tmcommit   = stms[new_alg].commit;
+      tx->tmread_obj  = stms[new_alg].read_obj;
+      tx->tmwrite_obj = stms[new_alg].write_obj;
+      tx->tmread_block  = stms[new_alg].read_block;
+      tx->tmwrite_block = stms[new_alg].write_block;
+  }
+
+  /**
+   *  Commit a transaction that was declared read-only, and then put back the
+   *  current algorithm's starting barriers.
+   */
+  TM_FASTCALL void commit_readonly(TxThread* tx)
+  {
+      TxThread::tmcommit_ronly(tx);
+      install_algorithm_local(curr_policy.ALG_ID, tx);
+  }
+
+  /**
+   *  The write barrier for transactions that were declared read-only
+   */
+  TM_FASTCALL void write_readonly(STM_WRITE_SIG(,,,))
+  {
+      UNRECOVERABLE("Write attempted in a read-only transaction.");
+  }
+
+  /*** The tvar<T> write barrier for declared read-only transactions */
+  TM_FASTCALL void write_obj_readonly(STM_WRITE_OBJ_SIG(,,,))
+  {
+      UNRECOVERABLE("Write attempted in a read-only transaction.");
+  }
+
+  /*** The block write barrier for declared read-only transactions */
+  void write_block_readonly(STM_WRITE_BLOCK_SIG(,,,))
+  {
+      UNRECOVERABLE("Write attempted in a read-only transaction.");
   }
 
   /**
@@ -46,10 +85,13 @@ namespace stm
    */
   void install_algorithm(int new_alg, TxThread* tx)
   {
-      // diagnostic message
-      if (tx)
+      // diagnostic message.  The install from sys_init has no thread, and
+      // is not a switch
+      if (tx) {
           printf("[%u] switching from %s to %s\n", tx->id,
                  stms[curr_policy.ALG_ID].name, stms[new_alg].name);
+          alg_switches = alg_switches + 1;
+      }
       if (!stms[new_alg].privatization_safe)
           printf("Warning: Algorithm %s is not privatization-safe!\n",
                  stms[new_alg].name);
@@ -67,11 +109,18 @@ namespace stm
           threads[i]->tmread     = stms[new_alg].read;
           threads[i]->tmwrite    = stms[new_alg].write;
           threads[i]->tmcommit   = stms[new_alg].commit;
+          threads[i]->tmread_obj  = stms[new_alg].read_obj;
+          threads[i]->tmwrite_obj = stms[new_alg].write_obj;
+          threads[i]->tmread_block  = stms[new_alg].read_block;
+          threads[i]->tmwrite_block = stms[new_alg].write_block;
           threads[i]->consec_aborts  = 0;
       }
 
       TxThread::tmrollback = stms[new_alg].rollback;
       TxThread::tmirrevoc  = stms[new_alg].irrevoc;
+      TxThread::tmread_ronly   = stms[new_alg].read_ronly;
+      TxThread::tmcommit_ronly = stms[new_alg].commit_ronly
+                               ? stms[new_alg].commit_ronly : stms[new_alg].commit;
       curr_policy.ALG_ID   = new_alg;
       CFENCE;
       TxThread::tmbegin    = stms[new_alg].begin;
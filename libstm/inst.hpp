@@ -27,6 +27,9 @@ namespace stm
   /*** make just this thread use a new algorith (use in ctors) */
   void install_algorithm_local(int new_alg, TxThread* tx);
 
+  /*** number of algorithm switches since sys_init */
+  extern volatile uint64_t alg_switches;
+
 } // namespace stm
 
 #endif // INST_HPP__
@@ -33,6 +33,13 @@ namespace {
    */
   AbortHandler old_abort_handler = NULL;
 
+  /**
+   *  How many consecutive aborts a transaction may suffer while trying to
+   *  become inevitable, before it gives up on concurrent inevitability and
+   *  takes the serial path instead.
+   */
+  const uint32_t INEV_ATTEMPTS = 8;
+
   /**
    *  Handler for abort attempts while irrevocable. Useful for trapping problems
    *  early.
@@ -66,6 +73,10 @@ namespace {
       tx.tmread           = stms[curr_policy.ALG_ID].read;
       tx.tmwrite          = stms[curr_policy.ALG_ID].write;
       tx.tmcommit         = stms[curr_policy.ALG_ID].commit;
+      tx.tmread_obj       = stms[curr_policy.ALG_ID].read_obj;
+      tx.tmwrite_obj      = stms[curr_policy.ALG_ID].write_obj;
+      tx.tmread_block     = stms[curr_policy.ALG_ID].read_block;
+      tx.tmwrite_block    = stms[curr_policy.ALG_ID].write_block;
       tx.tmrollback       = stms[curr_policy.ALG_ID].rollback;
       TxThread::tmirrevoc = stms[curr_policy.ALG_ID].irrevoc;
       tx.tmabort          = old_abort_handler;
@@ -101,6 +112,10 @@ namespace {
       tx.tmread           = stms[CGL].read;
       tx.tmwrite          = stms[CGL].write;
       tx.tmcommit         = commit_irrevocable;
+      tx.tmread_obj       = stms[CGL].read_obj;
+      tx.tmwrite_obj      = stms[CGL].write_obj;
+      tx.tmread_block     = stms[CGL].read_block;
+      tx.tmwrite_block    = stms[CGL].write_block;
       tx.tmrollback       = rollback_irrevocable;
       TxThread::tmirrevoc = stms[CGL].irrevoc;
       old_abort_handler   = tx.tmabort;
@@ -129,6 +144,10 @@ namespace stm
   void become_irrevoc()
   {
       TxThread* tx = Self;
+      // nothing to do if we're already irrevocable
+      if (tx->irrevocable)
+          return;
+
       // special code for degenerate STM implementations
       //
       // NB: stm::is_irrevoc relies on how this works, so if it changes then
@@ -136,7 +155,10 @@ namespace stm
       if (TxThread::tmirrevoc == stms[CGL].irrevoc)
           return;
 
-      if ((curr_policy.ALG_ID == MCS) || (curr_policy.ALG_ID == Ticket))
+      if ((curr_policy.ALG_ID == MCS) || (curr_policy.ALG_ID == Ticket) ||
+          (curr_policy.ALG_ID == CohortCGL) ||
+          (curr_policy.ALG_ID == CohortMCS) ||
+          (curr_policy.ALG_ID == CohortTicket))
           return;
 
       if (curr_policy.ALG_ID == Serial) {
@@ -150,6 +172,19 @@ namespace stm
           return;
       }
 
+      // algorithms with concurrent inevitability let other transactions keep
+      // running.  If we can't become inevitable in place, we abort and will
+      // try again when the retry reaches this point.  After too many aborts
+      // in a row, we stop trying, and fall through to the serial path, which
+      // is sure to make progress.
+      if (stms[curr_policy.ALG_ID].become_inev &&
+          (tx->consec_aborts < INEV_ATTEMPTS))
+      {
+          if (stms[curr_policy.ALG_ID].become_inev(tx))
+              return;
+          tx->tmabort(tx);
+      }
+
       // prevent new txns from starting.  If this fails, it means one of
       // three things:
       //
@@ -194,18 +229,26 @@ namespace stm
   }
 
   /**
-   * True if the current algorithm is irrevocable.
+   * True if the current transaction cannot abort, because it is irrevocable,
+   * the algorithm is, or it is in turbo mode.
    */
   bool is_irrevoc(const TxThread& tx)
   {
       if (tx.irrevocable || TxThread::tmirrevoc == stms[CGL].irrevoc)
           return true;
-      if ((curr_policy.ALG_ID == MCS) || (curr_policy.ALG_ID  == Ticket))
+      if ((curr_policy.ALG_ID == MCS) || (curr_policy.ALG_ID  == Ticket) ||
+          (curr_policy.ALG_ID == CohortCGL) ||
+          (curr_policy.ALG_ID == CohortMCS) ||
+          (curr_policy.ALG_ID == CohortTicket))
           return true;
       if ((curr_policy.ALG_ID == TML) && (tx.tmlHasLock))
           return true;
       if (curr_policy.ALG_ID == Serial)
           return true;
+      // a turbo-mode transaction writes in place, and cannot abort
+      if (stms[curr_policy.ALG_ID].read_turbo &&
+          (tx.tmread == stms[curr_policy.ALG_ID].read_turbo))
+          return true;
       return false;
   }
 
@@ -0,0 +1,246 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  This file implements per-phase performance counters (see stm/perf.hpp).
+ *
+ *  Each thread opens one perf event per counter, on itself, counting user
+ *  mode only.  If the kernel lets us, we map each event's control page and
+ *  read the counter with rdpmc, using the page's sequence lock to get a
+ *  consistent (offset, index) pair; otherwise, or while the event is not
+ *  scheduled on the PMU, we fall back to read().
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stm/perf.hpp>
+#include <stm/lib_globals.hpp>
+
+#if defined(STM_OS_LINUX)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace stm
+{
+  const char* const perf_phase_names[PERF_PHASES] = {
+      "nontx", "begin", "body", "read", "write", "commit", "validate", "abort"
+  };
+
+  const char* const perf_counter_names[PERF_COUNTERS] = {
+      "cycles", "instructions", "llc_misses"
+  };
+
+  /*** a thread's counters, and what it has charged to each phase */
+  struct perf_state_t
+  {
+      int          fd[PERF_COUNTERS];       // -1 if not open
+      void*        page[PERF_COUNTERS];     // control page, or NULL
+      perf_phase_t phase;
+      uint64_t     last[PERF_COUNTERS];
+      uint64_t     value[PERF_PHASES][PERF_COUNTERS];
+      uint64_t     entries[PERF_PHASES];
+  };
+}
+
+using namespace stm;
+
+namespace
+{
+  bool enabled = false;
+
+  /*** counters that every thread managed to open */
+  bool available[PERF_COUNTERS];
+  bool hw_cycles = true;
+
+#if defined(STM_OS_LINUX)
+  /*** open one user-mode counter on the calling thread */
+  int open_counter(uint32_t type, uint64_t config)
+  {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+#if defined(STM_CPU_X86)
+  inline uint64_t rdpmc(uint32_t counter)
+  {
+      uint32_t lo, hi;
+      __asm__ volatile("rdpmc" : "=a" (lo), "=d" (hi) : "c" (counter));
+      return ((uint64_t)hi << 32) | lo;
+  }
+#endif
+
+  /*** read counter i of s */
+  uint64_t read_counter(perf_state_t* s, int i)
+  {
+#if defined(STM_CPU_X86)
+      volatile perf_event_mmap_page* pg = (perf_event_mmap_page*)s->page[i];
+      if (pg && pg->cap_user_rdpmc) {
+          uint32_t seq, idx;
+          uint64_t count;
+          do {
+              seq = pg->lock;
+              CFENCE;
+              idx = pg->index;
+              count = pg->offset;
+              if (idx) {
+                  // sign-extend the pmc_width-bit counter
+                  uint32_t shift = 64 - pg->pmc_width;
+                  count += (uint64_t)(((int64_t)rdpmc(idx - 1) << shift)
+                                      >> shift);
+              }
+              CFENCE;
+          } while (pg->lock != seq);
+          if (idx)
+              return count;
+      }
+#endif
+      uint64_t v = 0;
+      if (read(s->fd[i], &v, sizeof(v)) != sizeof(v))
+          return 0;
+      return v;
+  }
+#endif
+
+  /*** read counter i of s, or tick() for cycles without a cycle counter */
+  inline uint64_t sample(perf_state_t* s, int i)
+  {
+#if defined(STM_OS_LINUX)
+      if (s->fd[i] >= 0)
+          return read_counter(s, i);
+#endif
+      return (i == PERF_CYCLES) ? tick() : 0;
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  /*** Turn counting on if STM_PERF is set */
+  void perf_init()
+  {
+      const char* p = getenv("STM_PERF");
+      if (!p || !*p)
+          return;
+      enabled = true;
+      for (int i = 0; i < PERF_COUNTERS; ++i)
+          available[i] = true;
+  }
+
+  /*** Open the calling thread's counters */
+  perf_state_t* perf_open()
+  {
+      if (!enabled)
+          return NULL;
+      perf_state_t* s = new perf_state_t();
+      memset(s, 0, sizeof(*s));
+      for (int i = 0; i < PERF_COUNTERS; ++i) {
+          s->fd[i] = -1;
+          s->page[i] = NULL;
+      }
+
+#if defined(STM_OS_LINUX)
+      s->fd[PERF_CYCLES] =
+          open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+      s->fd[PERF_INSTRUCTIONS] =
+          open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+      s->fd[PERF_LLC_MISSES] =
+          open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+      for (int i = 0; i < PERF_COUNTERS; ++i) {
+          if (s->fd[i] < 0)
+              continue;
+          void* pg = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED,
+                          s->fd[i], 0);
+          s->page[i] = (pg == MAP_FAILED) ? NULL : pg;
+      }
+#endif
+
+      // NB: racy if threads are created concurrently, but both writers only
+      //     ever clear these flags
+      if (s->fd[PERF_CYCLES] < 0)
+          hw_cycles = false;
+      for (int i = PERF_INSTRUCTIONS; i < PERF_COUNTERS; ++i)
+          if (s->fd[i] < 0)
+              available[i] = false;
+
+      s->phase = PERF_NONTX;
+      for (int i = 0; i < PERF_COUNTERS; ++i)
+          s->last[i] = sample(s, i);
+      return s;
+  }
+
+  /*** Charge the counters to the current phase, and switch to p */
+  perf_phase_t perf_switch(TxThread* tx, perf_phase_t p, bool entering)
+  {
+      perf_state_t* s = tx->perf;
+      perf_phase_t old = s->phase;
+      for (int i = 0; i < PERF_COUNTERS; ++i) {
+          uint64_t now = sample(s, i);
+          s->value[old][i] += now - s->last[i];
+          s->last[i] = now;
+      }
+      if (entering)
+          ++s->entries[p];
+      s->phase = p;
+      return old;
+  }
+
+  /*** Sum the counters of one thread, or of all threads */
+  bool get_perf_counters(perf_totals_t* out, uint32_t id)
+  {
+      if (!enabled)
+          return false;
+      memset(out, 0, sizeof(*out));
+      out->hw_cycles = hw_cycles;
+      for (int i = 0; i < PERF_COUNTERS; ++i)
+          out->available[i] = available[i];
+      for (uint32_t t = 0; t < threadcount.val; ++t) {
+          perf_state_t* s = threads[t]->perf;
+          if (!s || (id && (t + 1 != id)))
+              continue;
+          for (int p = 0; p < PERF_PHASES; ++p) {
+              out->entries[p] += s->entries[p];
+              for (int i = 0; i < PERF_COUNTERS; ++i)
+                  out->value[p][i] += s->value[p][i];
+          }
+      }
+      return true;
+  }
+
+  /*** Print the totals of every phase */
+  void perf_report()
+  {
+      perf_totals_t t;
+      if (!get_perf_counters(&t))
+          return;
+      printf("Perf counters (cycles from %s):\n",
+             t.hw_cycles ? "the PMU" : "tick()");
+      printf("  %-10s %16s %16s %16s %12s\n", "phase", "cycles",
+             "instructions", "llc_misses", "entries");
+      for (int p = 0; p < PERF_PHASES; ++p) {
+          printf("  %-10s", perf_phase_names[p]);
+          for (int i = 0; i < PERF_COUNTERS; ++i) {
+              if (t.available[i])
+                  printf(" %16llu", (unsigned long long)t.value[p][i]);
+              else
+                  printf(" %16s", "-");
+          }
+          printf(" %12llu\n", (unsigned long long)t.entries[p]);
+      }
+  }
+} // namespace stm
@@ -70,8 +70,8 @@ namespace
   {
       // compute the read-only ratio
       uint32_t ropct = 0;
-      uint32_t txns = 0;
-      uint32_t rotxns = 0;
+      uint64_t txns = 0;
+      uint64_t rotxns = 0;
       for (uint32_t i = 0; i < threadcount.val; ++i) {
           txns += threads[i]->num_commits;
           rotxns += threads[i]->num_ro;
@@ -697,7 +697,7 @@ namespace
   TM_FASTCALL uint32_t pol_CBR_RO()
   {
       // compute the read-only ratio
-      uint32_t txns = 0, rotxns = 0;
+      uint64_t txns = 0, rotxns = 0;
       qtable_t q;
       for (uint32_t i = 0; i < threadcount.val; ++i) {
           txns += threads[i]->num_commits;
@@ -721,8 +721,8 @@ namespace
       // when the code runs.
       qtable_t q;
       if (C::uses_RO()) {
-          uint32_t txns = 0;
-          uint32_t rotxns = 0;
+          uint64_t txns = 0;
+          uint64_t rotxns = 0;
           for (uint32_t i = 0; i < threadcount.val; ++i) {
               txns += threads[i]->num_commits;
               rotxns += threads[i]->num_ro;
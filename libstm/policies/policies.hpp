@@ -285,7 +285,7 @@ namespace stm
   inline unsigned long long get_nontxtime()
   {
       // extimate the global nontx time per transaction
-      uint32_t commits = 1;
+      uint64_t commits = 1;
       unsigned long long nontxn_time = 0;
       for (unsigned z = 0; z < threadcount.val; z++){
           nontxn_time += threads[z]->total_nontxn_time;
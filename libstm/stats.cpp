@@ -0,0 +1,148 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  This file implements the runtime statistics snapshot (see stm/stats.hpp),
+ *  and the two formats we print it in.
+ */
+
+#include <cstring>
+#include <stm/stats.hpp>
+#include <stm/txthread.hpp>
+#include <stm/lib_globals.hpp>
+#include "policies/policies.hpp"
+#include "algs/algs.hpp"
+#include "inst.hpp"
+
+namespace stm
+{
+  /**
+   *  Sum the counters of every thread.  Threads keep running, so we read
+   *  each field once, and only the fields that their owners update with
+   *  plain stores.
+   */
+  void get_stats(stats_t* s)
+  {
+      memset(s, 0, sizeof(*s));
+      s->time_ns         = getElapsedTime();
+      s->algorithm       = stms[curr_policy.ALG_ID].name;
+      s->policy          = pols[curr_policy.POL_ID].name;
+      s->policy_switches = alg_switches;
+      s->threads         = threadcount.val;
+      s->validations_valid = stms[curr_policy.ALG_ID].counts_validations;
+#ifdef STM_COUNTCONSEC_YES
+      s->abort_hist_valid = true;
+#endif
+      for (uint32_t i = 0; i < s->threads; ++i) {
+          TxThread* tx = threads[i];
+          s->commits_rw  += tx->num_commits;
+          s->commits_ro  += tx->num_ro;
+          s->aborts      += tx->num_aborts;
+          s->restarts    += tx->num_restarts;
+          s->validations += tx->num_validations;
+#ifdef STM_COUNTCONSEC_YES
+          for (uint32_t b = 0; b < STATS_ABORT_BUCKETS; ++b)
+              s->abort_hist[b] += tx->abort_hist.buckets[b];
+          if (tx->abort_hist.max > s->abort_hist_max)
+              s->abort_hist_max = tx->abort_hist.max;
+#endif
+      }
+  }
+
+  /**
+   *  One JSON object per snapshot.  The validation count is null when the
+   *  algorithm does not count validations, and the histogram is null when it
+   *  is not being kept.
+   */
+  void write_stats_json(FILE* out, const stats_t& s)
+  {
+      fprintf(out, "{\"time_ns\": %llu, \"algorithm\": \"%s\", "
+              "\"policy\": \"%s\", \"policy_switches\": %llu, "
+              "\"threads\": %u, \"commits_rw\": %llu, \"commits_ro\": %llu, "
+              "\"aborts\": %llu, \"restarts\": %llu, \"validations\": ",
+              (unsigned long long)s.time_ns, s.algorithm, s.policy,
+              (unsigned long long)s.policy_switches, s.threads,
+              (unsigned long long)s.commits_rw,
+              (unsigned long long)s.commits_ro,
+              (unsigned long long)s.aborts, (unsigned long long)s.restarts);
+      if (s.validations_valid)
+          fprintf(out, "%llu", (unsigned long long)s.validations);
+      else
+          fprintf(out, "null");
+      fprintf(out, ", \"abort_histogram\": ");
+      if (s.abort_hist_valid) {
+          fprintf(out, "{\"buckets\": [");
+          for (uint32_t b = 0; b < STATS_ABORT_BUCKETS; ++b)
+              fprintf(out, "%s%llu", b ? ", " : "",
+                      (unsigned long long)s.abort_hist[b]);
+          fprintf(out, "], \"max\": %u}", s.abort_hist_max);
+      }
+      else {
+          fprintf(out, "null");
+      }
+      fprintf(out, "}\n");
+  }
+
+  /**
+   *  Prometheus text format.  Every count is a counter, so rates (e.g. of
+   *  aborts) come from rate() on the scraper.  The consecutive-abort
+   *  histogram is a counter per number of aborts, since we do not have the
+   *  sum that a Prometheus histogram needs.  Validations are left out when
+   *  the algorithm does not count them, rather than reported as zero.
+   */
+  void write_stats_prometheus(FILE* out, const stats_t& s)
+  {
+      fprintf(out, "# HELP rstm_info The algorithm and policy in use.\n"
+              "# TYPE rstm_info gauge\n"
+              "rstm_info{algorithm=\"%s\",policy=\"%s\"} 1\n",
+              s.algorithm, s.policy);
+      fprintf(out, "# HELP rstm_threads Threads that have called "
+              "thread_init.\n"
+              "# TYPE rstm_threads gauge\n"
+              "rstm_threads %u\n", s.threads);
+
+      struct { const char* name; const char* help; uint64_t value; } c[] = {
+          { "rstm_policy_switches_total", "Algorithm switches.",
+            s.policy_switches },
+          { "rstm_aborts_total", "Aborted transaction attempts.", s.aborts },
+          { "rstm_restarts_total", "Explicit restarts.", s.restarts },
+          // keep this last, so that it can be left out
+          { "rstm_validations_total", "Read set validations.",
+            s.validations }
+      };
+      fprintf(out, "# HELP rstm_commits_total Committed transactions.\n"
+              "# TYPE rstm_commits_total counter\n"
+              "rstm_commits_total{kind=\"rw\"} %llu\n"
+              "rstm_commits_total{kind=\"ro\"} %llu\n",
+              (unsigned long long)s.commits_rw,
+              (unsigned long long)s.commits_ro);
+      size_t counters = sizeof(c) / sizeof(c[0]);
+      if (!s.validations_valid)
+          --counters;
+      for (size_t i = 0; i < counters; ++i)
+          fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                  c[i].name, c[i].help, c[i].name, c[i].name,
+                  (unsigned long long)c[i].value);
+
+      if (!s.abort_hist_valid)
+          return;
+      fprintf(out, "# HELP rstm_commits_by_aborts_total Committed "
+              "transactions by consecutive aborts before the commit.\n"
+              "# TYPE rstm_commits_by_aborts_total counter\n");
+      for (uint32_t b = 0; b < STATS_ABORT_BUCKETS; ++b)
+          fprintf(out, "rstm_commits_by_aborts_total{aborts=\"%u%s\"} %llu\n",
+                  b, (b == STATS_ABORT_BUCKETS - 1) ? "+" : "",
+                  (unsigned long long)s.abort_hist[b]);
+      fprintf(out, "# HELP rstm_consecutive_aborts_max Most consecutive "
+              "aborts of one transaction.\n"
+              "# TYPE rstm_consecutive_aborts_max gauge\n"
+              "rstm_consecutive_aborts_max %u\n", s.abort_hist_max);
+  }
+} // namespace stm
@@ -0,0 +1,129 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  This file implements the background statistics reporter (see
+ *  stm/stats.hpp).
+ *
+ *  The reporter thread sleeps on a condition variable, so that shutdown
+ *  does not have to wait out the interval, and takes a snapshot each time
+ *  the interval expires.  It never touches transactional metadata other
+ *  than through get_stats, so it cannot slow down or block transactions.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <pthread.h>
+#include <sys/time.h>
+#include <stm/stats.hpp>
+
+using namespace stm;
+
+namespace
+{
+  const char*     path = NULL;          // NULL when not exporting
+  std::string     tmp_path;
+  bool            prometheus = false;
+  uint32_t        interval_ms = 1000;
+  pthread_t       reporter;
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t  wake = PTHREAD_COND_INITIALIZER;
+  bool            done = false;
+
+  /*** write one snapshot to a temporary file, and rename it into place */
+  void write_snapshot()
+  {
+      stats_t s;
+      get_stats(&s);
+      FILE* out = fopen(tmp_path.c_str(), "w");
+      if (!out) {
+          fprintf(stderr, "Warning: could not write %s\n", tmp_path.c_str());
+          return;
+      }
+      if (prometheus)
+          write_stats_prometheus(out, s);
+      else
+          write_stats_json(out, s);
+      fclose(out);
+      if (rename(tmp_path.c_str(), path))
+          fprintf(stderr, "Warning: could not rename %s\n", tmp_path.c_str());
+  }
+
+  /*** the reporter thread: one snapshot per interval until shutdown */
+  void* reporter_main(void*)
+  {
+      pthread_mutex_lock(&lock);
+      while (!done) {
+          timeval now;
+          gettimeofday(&now, NULL);
+          uint64_t ns = (uint64_t)now.tv_usec * 1000 +
+                        (uint64_t)interval_ms * 1000000;
+          timespec until;
+          until.tv_sec  = now.tv_sec + ns / 1000000000;
+          until.tv_nsec = ns % 1000000000;
+          while (!done &&
+                 (pthread_cond_timedwait(&wake, &lock, &until) == 0)) { }
+          if (done)
+              break;
+          pthread_mutex_unlock(&lock);
+          write_snapshot();
+          pthread_mutex_lock(&lock);
+      }
+      pthread_mutex_unlock(&lock);
+      return NULL;
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  /**
+   *  Start exporting if STM_STATS_FILE is set.  STM_STATS_FORMAT picks json
+   *  (the default) or prometheus, and STM_STATS_INTERVAL the period in ms.
+   */
+  void stats_export_init()
+  {
+      const char* p = getenv("STM_STATS_FILE");
+      if (!p || !*p)
+          return;
+      const char* f = getenv("STM_STATS_FORMAT");
+      prometheus = f && !strcmp(f, "prometheus");
+      const char* i = getenv("STM_STATS_INTERVAL");
+      if (i && atoi(i) > 0)
+          interval_ms = atoi(i);
+      tmp_path = std::string(p) + ".tmp";
+      path = p;
+      if (pthread_create(&reporter, NULL, reporter_main, NULL)) {
+          fprintf(stderr, "Warning: could not start the stats reporter\n");
+          path = NULL;
+          return;
+      }
+      printf("Exporting %s statistics to %s every %u ms\n",
+             prometheus ? "prometheus" : "json", path, interval_ms);
+  }
+
+  /**
+   *  Stop the reporter, and write one last snapshot so that the file holds
+   *  the final totals.
+   */
+  void stats_export_shutdown()
+  {
+      if (!path)
+          return;
+      pthread_mutex_lock(&lock);
+      done = true;
+      pthread_cond_signal(&wake);
+      pthread_mutex_unlock(&lock);
+      pthread_join(reporter, NULL);
+      write_snapshot();
+      path = NULL;
+  }
+} // namespace stm
@@ -0,0 +1,241 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  This file implements the writer side of transaction traces (see
+ *  stm/trace.hpp).
+ *
+ *  Each traced thread fills a chunk of records.  When the chunk is full, the
+ *  thread appends it to a FIFO and takes an empty chunk from a free list.  A
+ *  single writer thread drains the FIFO with fwrite and returns the chunks
+ *  to the free list.  Since there is one writer and one FIFO, each file
+ *  receives its chunks in the order its thread filled them.  If the writer
+ *  falls MAX_QUEUED chunks behind, traced threads wait for it rather than
+ *  allocate without bound.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <stm/trace.hpp>
+#include <stm/lib_globals.hpp>
+
+using namespace stm;
+
+namespace
+{
+  /*** a chunk of records, and the file it belongs to */
+  struct chunk_t
+  {
+      chunk_t*    next;
+      FILE*       out;
+      uint32_t    count;
+      trace_rec_t recs[TRACE_CHUNK_RECS];
+  };
+
+  /**
+   *  A thread's trace.  The trace_buf_t comes first, so that the pointer in
+   *  the TxThread is also a pointer to this.
+   */
+  struct file_t
+  {
+      trace_buf_t buf;
+      chunk_t*    chunk;        // the chunk that buf.recs points into
+      FILE*       out;
+      uint64_t    events;       // events written so far
+  };
+
+  /*** full chunks we let pile up before traced threads wait */
+  const uint32_t MAX_QUEUED = 64;
+
+  const char*     prefix = NULL;        // NULL when not tracing
+  pthread_t       writer;
+  pthread_mutex_t lock  = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t  work  = PTHREAD_COND_INITIALIZER;  // queued chunk, or done
+  pthread_cond_t  space = PTHREAD_COND_INITIALIZER;  // a chunk was written
+  chunk_t*        head = NULL;          // FIFO of full chunks
+  chunk_t*        tail = NULL;
+  uint32_t        queued = 0;
+  chunk_t*        free_chunks = NULL;
+  bool            done = false;
+  file_t*         files[MAX_THREADS];
+
+  /*** append c to the FIFO (caller holds lock) */
+  void enqueue(chunk_t* c)
+  {
+      c->next = NULL;
+      if (tail)
+          tail->next = c;
+      else
+          head = c;
+      tail = c;
+      ++queued;
+      pthread_cond_signal(&work);
+  }
+
+  /*** get an empty chunk, waiting if the writer is too far behind */
+  chunk_t* get_chunk()
+  {
+      while (!free_chunks && (queued >= MAX_QUEUED))
+          pthread_cond_wait(&space, &lock);
+      chunk_t* c = free_chunks;
+      if (c)
+          free_chunks = c->next;
+      else
+          c = (chunk_t*)malloc(sizeof(chunk_t));
+      return c;
+  }
+
+  /*** the writer thread: write chunks in FIFO order until shutdown */
+  void* writer_main(void*)
+  {
+      pthread_mutex_lock(&lock);
+      while (true) {
+          while (!head && !done)
+              pthread_cond_wait(&work, &lock);
+          if (!head)
+              break;
+          chunk_t* c = head;
+          head = c->next;
+          if (!head)
+              tail = NULL;
+          --queued;
+          pthread_mutex_unlock(&lock);
+
+          if (fwrite(c->recs, sizeof(trace_rec_t), c->count, c->out) !=
+              c->count)
+              fprintf(stderr, "Warning: trace write failed\n");
+
+          pthread_mutex_lock(&lock);
+          c->next = free_chunks;
+          free_chunks = c;
+          pthread_cond_broadcast(&space);
+      }
+      pthread_mutex_unlock(&lock);
+      return NULL;
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  /**
+   *  Start tracing if STM_TRACE is set.  Threads created after this get a
+   *  trace file.
+   */
+  void trace_init()
+  {
+      const char* p = getenv("STM_TRACE");
+      if (!p || !*p)
+          return;
+      if (pthread_create(&writer, NULL, writer_main, NULL)) {
+          fprintf(stderr, "Warning: could not start the trace writer\n");
+          return;
+      }
+      prefix = p;
+      printf("Tracing transactions to %s.<thread>\n", prefix);
+  }
+
+  /**
+   *  Create the trace file for thread id and write its header.  On failure
+   *  we warn and do not trace this thread.
+   */
+  trace_buf_t* trace_open(uint32_t id)
+  {
+      if (!prefix)
+          return NULL;
+      char name[1024];
+      snprintf(name, sizeof(name), "%s.%u", prefix, id);
+      FILE* out = fopen(name, "wb");
+      if (!out) {
+          fprintf(stderr, "Warning: could not open trace file %s\n", name);
+          return NULL;
+      }
+
+      trace_header_t h;
+      memset(&h, 0, sizeof(h));
+      strncpy(h.magic, "RSTMTRC", sizeof(h.magic));
+      h.version    = TRACE_VERSION;
+      h.thread     = id;
+      h.word_bytes = sizeof(void*);
+      h.rec_bytes  = sizeof(trace_rec_t);
+      fwrite(&h, sizeof(h), 1, out);
+
+      file_t* f = new file_t();
+      pthread_mutex_lock(&lock);
+      f->chunk = get_chunk();
+      pthread_mutex_unlock(&lock);
+      f->out        = out;
+      f->events     = 0;
+      f->buf.recs   = f->chunk->recs;
+      f->buf.count  = 0;
+      f->buf.last   = tick();
+      files[id - 1] = f;
+      return &f->buf;
+  }
+
+  /**
+   *  Called from trace_event when the current chunk is full: queue it for
+   *  the writer and continue in an empty one.
+   */
+  void trace_flush(TxThread* tx)
+  {
+      file_t* f = (file_t*)tx->trace;
+      f->chunk->out   = f->out;
+      f->chunk->count = f->buf.count;
+      f->events      += f->buf.count;
+      pthread_mutex_lock(&lock);
+      enqueue(f->chunk);
+      f->chunk = get_chunk();
+      pthread_mutex_unlock(&lock);
+      f->buf.recs  = f->chunk->recs;
+      f->buf.count = 0;
+  }
+
+  /**
+   *  Stop tracing: queue every thread's partial chunk, wait for the writer
+   *  to drain the FIFO, and close the files.  Events after this are
+   *  dropped.
+   */
+  void trace_shutdown()
+  {
+      if (!prefix)
+          return;
+
+      uint64_t events = 0;
+      uint32_t count = 0;
+      pthread_mutex_lock(&lock);
+      for (uint32_t i = 0; i < threadcount.val; ++i) {
+          if (!threads[i]->trace)
+              continue;
+          threads[i]->trace = NULL;
+          file_t* f = files[i];
+          f->chunk->out   = f->out;
+          f->chunk->count = f->buf.count;
+          f->events      += f->buf.count;
+          enqueue(f->chunk);
+      }
+      done = true;
+      pthread_cond_signal(&work);
+      pthread_mutex_unlock(&lock);
+      pthread_join(writer, NULL);
+
+      for (uint32_t i = 0; i < threadcount.val; ++i) {
+          if (!files[i])
+              continue;
+          fclose(files[i]->out);
+          events += files[i]->events;
+          ++count;
+      }
+      printf("Trace: %llu events in %u files (%s.*)\n",
+             (unsigned long long)events, count, prefix);
+      prefix = NULL;
+  }
+} // namespace stm
@@ -9,9 +9,15 @@
  */
 
 #include <setjmp.h>
+#include <cstdio>
+#include <sched.h>
+#include <unistd.h>
 #include <iostream>
 #include <stm/txthread.hpp>
 #include <stm/lib_globals.hpp>
+#include <stm/trace.hpp>
+#include <stm/perf.hpp>
+#include <stm/stats.hpp>
 #include "policies/policies.hpp"
 #include "algs/tml_inline.hpp"
 #include "algs/algs.hpp"
@@ -41,9 +47,35 @@ namespace
                                                       , NULL, 0
 #endif
                                                );
+      // run deferred abort work, now that rollback is complete
+      if (tx->abort_handlers.size() || tx->commit_handlers.size())
+          run_abort_handlers(tx);
       // need to null out the scope
       longjmp(*scope, 1);
   }
+
+  /**
+   *  The NUMA node of the CPU that we are running on, for cohort locks.  We
+   *  only ask once, when the thread is created, so a thread that migrates
+   *  keeps its first node.  That costs locality, never correctness.
+   */
+  uint32_t
+  current_numa_node()
+  {
+#if defined(STM_OS_LINUX)
+      int cpu = sched_getcpu();
+      if (cpu < 0)
+          return 0;
+      char path[64];
+      for (uint32_t node = 0; node < COHORT_MAX_NODES; ++node) {
+          snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpu%d",
+                   node, cpu);
+          if (!access(path, F_OK))
+              return node;
+      }
+#endif
+      return 0;
+  }
 } // (anonymous namespace)
 
 namespace stm
@@ -60,25 +92,36 @@ namespace stm
       : nesting_depth(0),
         allocator(),
         num_commits(0), num_aborts(0), num_restarts(0),
-        num_ro(0), scope(NULL),
+        num_ro(0), num_validations(0), scope(NULL),
 #ifdef STM_PROTECT_STACK
         stack_high(NULL),
         stack_low((void**)~0x0),
 #endif
-        start_time(0), tmlHasLock(false), undo_log(64), vlist(64), writes(64),
-        r_orecs(64), locks(64),
+        start_time(0), extend_credit(0), tmlHasLock(false), undo_log(64), vlist(64), writes(64),
+        r_orecs(64), r_regions(64), locks(64),
         wf((filter_t*)FILTER_ALLOC(sizeof(filter_t))),
         rf((filter_t*)FILTER_ALLOC(sizeof(filter_t))),
         prio(0), consec_aborts(0), seed((unsigned long)&id), myRRecs(64),
-        order(-1), alive(1),
+        order(-1), det_lane(-1), alive(1),
         r_bytelocks(64), w_bytelocks(64), r_bitlocks(64), w_bitlocks(64),
-        my_mcslock(new mcs_qnode_t()),
-        cm_ts(INT_MAX),
+        my_mcslock(new mcs_qnode_t()), numa_node(current_numa_node()),
+        cm_ts(INT_MAX), cm_karma(0), cm_waiting(0),
+        cm_winner(0),
         cf((filter_t*)FILTER_ALLOC(sizeof(filter_t))),
         nanorecs(64),
+        shrink_wsig((filter_t*)FILTER_ALLOC(sizeof(filter_t))),
+        shrink_pred((filter_t*)FILTER_ALLOC(sizeof(filter_t))),
+        shrink_waiting(0), shrink_hot(false),
         begin_wait(0),
         strong_HG(),
-        irrevocable(false)
+        irrevocable(false),
+        commit_handlers(8), abort_handlers(8)
+#ifdef STM_TRACE
+        , trace(NULL)
+#endif
+#ifdef STM_PERF
+        , perf(NULL)
+#endif
   {
       // prevent new txns from starting.
       while (true) {
@@ -123,9 +166,12 @@ namespace stm
       // clear filters
       wf->clear();
       rf->clear();
+      shrink_wsig->clear();
+      shrink_pred->clear();
 
       // configure my TM instrumentation
       install_algorithm_local(curr_policy.ALG_ID, this);
+      tmabort = abort_handler;
 
       // set the pointer to this TxThread
       threads[id-1] = this;
@@ -133,6 +179,16 @@ namespace stm
       // set the epoch to default
       epochs[id-1].val = EPOCH_MAX;
 
+#ifdef STM_TRACE
+      // open this thread's trace file, if we are tracing
+      trace = trace_open(id);
+#endif
+
+#ifdef STM_PERF
+      // open this thread's performance counters, if we are counting
+      perf = perf_open();
+#endif
+
       // NB: at this point, we could change the mode based on the thread
       //     count.  The best way to do so would be to install ProfileTM.  We
       //     would need to be very careful, though, in case another thread is
@@ -170,12 +226,18 @@ namespace stm
   bool TM_FASTCALL (*volatile TxThread::tmbegin)(TxThread*) = begin_CGL;
 
   /**
-   *  The tmrollback, tmabort, and tmirrevoc pointers
+   *  The tmrollback, abort_handler, and tmirrevoc pointers
    */
   scope_t* (*TxThread::tmrollback)(STM_ROLLBACK_SIG(,,));
-  NORETURN void (*TxThread::tmabort)(TxThread*) = default_abort_handler;
+  NORETURN void (*TxThread::abort_handler)(TxThread*) = default_abort_handler;
   bool (*TxThread::tmirrevoc)(TxThread*) = NULL;
 
+  /**
+   *  The barriers for declared read-only transactions
+   */
+  void* TM_FASTCALL (*TxThread::tmread_ronly)(STM_READ_SIG(,,)) = NULL;
+  void TM_FASTCALL (*TxThread::tmcommit_ronly)(TxThread*) = NULL;
+
   /*** the init factory */
   void TxThread::thread_init()
   {
@@ -200,6 +262,57 @@ namespace stm
   }
 
 
+  /**
+   *  Register work to run once the current transaction commits.  Outside of
+   *  a transaction, the work runs immediately.
+   */
+  void on_commit(void (*fn)(void*), void* arg)
+  {
+      TxThread* tx = Self;
+      if (!tx->nesting_depth) {
+          fn(arg);
+          return;
+      }
+      tx->commit_handlers.insert(callback_t(fn, arg));
+  }
+
+  /**
+   *  Register work to run if the current transaction aborts.  The work runs
+   *  once per aborted attempt.  Outside of a transaction, this is a no-op.
+   */
+  void on_abort(void (*fn)(void*), void* arg)
+  {
+      TxThread* tx = Self;
+      if (tx->nesting_depth)
+          tx->abort_handlers.insert(callback_t(fn, arg));
+  }
+
+  /**
+   *  Run the commit handlers in registration order, and discard the abort
+   *  handlers.  This runs after writeback and allocator cleanup, once the
+   *  thread is no longer in a transaction.
+   */
+  void run_commit_handlers(TxThread* tx)
+  {
+      tx->abort_handlers.reset();
+      foreach (CallbackList, i, tx->commit_handlers)
+          i->fn(i->arg);
+      tx->commit_handlers.reset();
+  }
+
+  /**
+   *  Run the abort handlers in registration order, and discard the commit
+   *  handlers.  This runs after rollback, before control returns to the
+   *  start of the transaction.
+   */
+  void run_abort_handlers(TxThread* tx)
+  {
+      tx->commit_handlers.reset();
+      foreach (CallbackList, i, tx->abort_handlers)
+          i->fn(i->arg);
+      tx->abort_handlers.reset();
+  }
+
   /**
    *  When the transactional system gets shut down, we call this to dump stats
    */
@@ -210,9 +323,9 @@ namespace stm
 
       uint64_t nontxn_count = 0;                // time outside of txns
       uint32_t pct_ro       = 0;                // read only txn ratio
-      uint32_t txn_count    = 0;                // total txns
-      uint32_t rw_txns      = 0;                // rw commits
-      uint32_t ro_txns      = 0;                // ro commits
+      uint64_t txn_count    = 0;                // total txns
+      uint64_t rw_txns      = 0;                // rw commits
+      uint64_t ro_txns      = 0;                // ro commits
       for (uint32_t i = 0; i < threadcount.val; i++) {
           std::cout << "Thread: "       << threads[i]->id
                     << "; RW Commits: " << threads[i]->num_commits
@@ -230,13 +343,25 @@ namespace stm
 
       std::cout << "Total nontxn work:\t" << nontxn_count << std::endl;
 
+#ifdef STM_PERF
+      perf_report();
+#endif
+
+#ifdef STM_STATS_EXPORT
+      stats_export_shutdown();
+#endif
+
+#ifdef STM_TRACE
+      trace_shutdown();
+#endif
+
       // if we ever switched to ProfileApp, then we should print out the
       // ProfileApp custom output.
       if (app_profiles) {
-          uint32_t divisor =
+          uint64_t divisor =
               (curr_policy.ALG_ID == ProfileAppAvg) ? txn_count : 1;
           if (divisor == 0)
-              divisor = 0u - 1u; // unsigned infinity :)
+              divisor = ~0ull; // unsigned infinity :)
 
           std::cout << "# " << stms[curr_policy.ALG_ID].name << " #" << std::endl;
           std::cout << "# read_ro, read_rw_nonraw, read_rw_raw, write_nonwaw, write_waw, txn_time, "
@@ -357,6 +482,21 @@ namespace stm
               printf("STM_CONFIG environment variable not found... using %s\n", cfg);
           init_lib_name = cfg;
 
+#ifdef STM_TRACE
+          // start the trace writer, if STM_TRACE names a file prefix
+          trace_init();
+#endif
+
+#ifdef STM_PERF
+          // turn on performance counters, if STM_PERF is set
+          perf_init();
+#endif
+
+#ifdef STM_STATS_EXPORT
+          // start the stats reporter, if STM_STATS_FILE names a file
+          stats_export_init();
+#endif
+
           // now initialize the the adaptive policies
           pol_init(cfg);
 
@@ -369,9 +509,13 @@ namespace stm
           for (unsigned i = 0; i < profile_txns; i++)
               profiles[i].clear();
 
-          // Initialize the global abort handler.
-          if (conflict_abort_handler)
-              TxThread::tmabort = conflict_abort_handler;
+          // Initialize the global abort handler, and give it to any threads
+          // that already exist.
+          if (conflict_abort_handler) {
+              TxThread::abort_handler = conflict_abort_handler;
+              for (unsigned i = 0; i < threadcount.val; ++i)
+                  threads[i]->tmabort = conflict_abort_handler;
+          }
 
           // now set the phase
           set_policy(cfg);